@@ -0,0 +1,202 @@
+/*
+ * Měření základních operací stromu pro rekurzivní (rec/btree.c)
+ * i iterativní (iter/btree.c) implementaci, soubor se překládá s každou
+ * z nich (make bench v adresáři rec nebo iter).
+ *
+ * Pro každý proud klíčů (náhodná permutace, seřazené, sestupně seřazené
+ * a Zipfovo rozdělení s opakováním klíčů) a velikost stromu se měří
+ * vložení, vyhledání a smazání všech klíčů proudu, inorder průchod,
+ * zrušení a vyvážení stromu (bst_balance). Časy jsou v ns na operaci,
+ * u průchodu, zrušení a vyvážení v ns na uzel. Hloubka je výška stromu
+ * po vložení, tedy největší hloubka rekurze (rec) nebo zásobníku (iter).
+ * RSS je dosavadní maximum procesu v KiB.
+ *
+ * Klíče jsou typu char, strom má tedy nejvýše 256 uzlů.
+ *
+ * Použití: ./bench [počet operací na měření]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "btree.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define BENCH_MAX_KEYS 256
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+// Druh proudu klíčů
+typedef enum bench_stream {
+  BENCH_RANDOM,
+  BENCH_SORTED,
+  BENCH_REVERSE,
+  BENCH_ZIPF
+} bench_stream_t;
+
+static const char *bench_stream_names[] = {"random", "sorted", "reverse",
+                                           "zipf"};
+
+// Součet časů jednoho měření v sekundách
+typedef struct bench_times {
+  double insert;
+  double search;
+  double delete;
+  double inorder;
+  double dispose;
+  double balance;
+} bench_times_t;
+
+/*
+ * Vytvoří proud count klíčů z prvních count klíčů typu char (od -128).
+ */
+static void bench_make_stream(bench_stream_t stream, char keys[], int count) {
+  for (int i = 0; i < count; i++) {
+    keys[i] = (char)(i - 128);
+  }
+  switch (stream) {
+  case BENCH_RANDOM:
+    for (int i = count - 1; i > 0; i--) {
+      int j = (int)(bench_random() % (uint64_t)(i + 1));
+      char key = keys[i];
+      keys[i] = keys[j];
+      keys[j] = key;
+    }
+    break;
+  case BENCH_SORTED:
+    break;
+  case BENCH_REVERSE:
+    for (int i = 0; i < count / 2; i++) {
+      char key = keys[i];
+      keys[i] = keys[count - 1 - i];
+      keys[count - 1 - i] = key;
+    }
+    break;
+  case BENCH_ZIPF: {
+    // The key of rank r is picked with weight 1/r, ranks in key order.
+    double cdf[BENCH_MAX_KEYS];
+    double total = 0;
+    for (int i = 0; i < count; i++) {
+      total += 1.0 / (i + 1);
+      cdf[i] = total;
+    }
+    char ranked[BENCH_MAX_KEYS];
+    for (int i = 0; i < count; i++) {
+      ranked[i] = keys[i];
+    }
+    for (int i = 0; i < count; i++) {
+      double u = (double)(bench_random() >> 11) / (1ULL << 53) * total;
+      int rank = 0;
+      while (rank < count - 1 && cdf[rank] < u) {
+        rank++;
+      }
+      keys[i] = ranked[rank];
+    }
+    break;
+  }
+  }
+}
+
+static double bench_seconds(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void bench_insert_all(bst_node_t **tree, const char keys[], int count) {
+  for (int i = 0; i < count; i++) {
+    bst_insert(tree, keys[i], i);
+  }
+}
+
+/*
+ * Jedno měření: rounds opakování všech operací nad proudem keys.
+ */
+static void bench_run(bench_stream_t stream, const char keys[], int count,
+                      int rounds) {
+  bench_times_t times = {0, 0, 0, 0, 0, 0};
+  bst_items_t items = {NULL, 0, 0};
+  long nodes = 0;
+  long found = 0;
+  int depth = 0;
+  int value;
+
+  for (int round = 0; round < rounds; round++) {
+    bst_node_t *tree;
+    bst_init(&tree);
+
+    clock_t start = clock();
+    bench_insert_all(&tree, keys, count);
+    times.insert += bench_seconds(start);
+
+    start = clock();
+    for (int i = 0; i < count; i++) {
+      found += bst_search(tree, keys[i], &value);
+    }
+    times.search += bench_seconds(start);
+
+    items.size = 0;
+    start = clock();
+    bst_inorder(tree, &items);
+    times.inorder += bench_seconds(start);
+    nodes += items.size;
+    if (round == 0) {
+      depth = bst_height(tree);
+    }
+
+    start = clock();
+    for (int i = 0; i < count; i++) {
+      bst_delete(&tree, keys[i]);
+    }
+    times.delete += bench_seconds(start);
+
+    bench_insert_all(&tree, keys, count);
+    start = clock();
+    bst_dispose(&tree);
+    times.dispose += bench_seconds(start);
+
+    bench_insert_all(&tree, keys, count);
+    start = clock();
+    bst_balance(&tree);
+    times.balance += bench_seconds(start);
+    bst_dispose(&tree);
+  }
+  free(items.nodes);
+
+  if (found != (long)count * rounds) {
+    printf("[W] Missing keys\n");
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double ops = (double)count * rounds;
+  printf("%-8s %5d %5ld %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %6d %8ld\n",
+         bench_stream_names[stream], count, nodes / rounds,
+         times.insert * 1e9 / ops, times.search * 1e9 / ops,
+         times.delete * 1e9 / ops, times.inorder * 1e9 / nodes,
+         times.dispose * 1e9 / nodes, times.balance * 1e9 / nodes, depth,
+         usage.ru_maxrss);
+}
+
+int main(int argc, char *argv[]) {
+  long operations = argc > 1 ? atol(argv[1]) : 2000000;
+
+  printf("%-8s %5s %5s %8s %8s %8s %8s %8s %8s %6s %8s\n", "stream", "keys",
+         "nodes", "insert", "search", "delete", "inorder", "dispose",
+         "balance", "depth", "rss KiB");
+  char keys[BENCH_MAX_KEYS];
+  for (int stream = BENCH_RANDOM; stream <= BENCH_ZIPF; stream++) {
+    for (int count = 16; count <= BENCH_MAX_KEYS; count *= 4) {
+      bench_make_stream(stream, keys, count);
+      int rounds = (int)(operations / count);
+      bench_run(stream, keys, count, rounds > 0 ? rounds : 1);
+    }
+  }
+  return 0;
+}
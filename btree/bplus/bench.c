@@ -0,0 +1,104 @@
+/*
+ * Srovnání B+ stromu s binárním stromem bst_i64 ze souboru gen/bst_gen.h.
+ *
+ * Použití: ./bench [maximální počet klíčů]
+ */
+#include "bplus.h"
+#include "../gen/bst_gen.h"
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+static double bench_ns(clock_t start, long ops) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / ops;
+}
+
+int main(int argc, char *argv[]) {
+  long max_keys = argc > 1 ? atol(argv[1]) : 1000000;
+
+  printf("%9s %-6s %9s %9s %9s %9s\n", "keys", "tree", "insert", "search",
+         "scan", "delete");
+  for (long n = 10000; n <= max_keys; n *= 10) {
+    int64_t *keys = malloc(n * sizeof(int64_t));
+    if (keys == NULL) {
+      return 1;
+    }
+    for (long i = 0; i < n; i++) {
+      keys[i] = (int64_t)(bench_random() >> 1);
+    }
+
+    long checksum = 0;
+    int value;
+    clock_t start;
+
+    bst_i64_node_t *bst;
+    bst_i64_init(&bst);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      bst_i64_insert(&bst, keys[i], (int)i);
+    }
+    double bst_insert = bench_ns(start, n);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      checksum += bst_i64_search(bst, keys[(i * 7919) % n], &value);
+    }
+    double bst_search = bench_ns(start, n);
+    start = clock();
+    bst_i64_items_t items = {NULL, 0, 0};
+    bst_i64_inorder(bst, &items);
+    for (int i = 0; i < items.size; i++) {
+      checksum += items.nodes[i]->value;
+    }
+    free(items.nodes);
+    double bst_scan = bench_ns(start, n);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      bst_i64_delete(&bst, keys[i]);
+    }
+    double bst_delete = bench_ns(start, n);
+    printf("%9ld %-6s %9.1f %9.1f %9.1f %9.1f\n", n, "binary", bst_insert,
+           bst_search, bst_scan, bst_delete);
+
+    bpt_node_t *bpt;
+    bpt_init(&bpt);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      bpt_insert(&bpt, keys[i], (int)i);
+    }
+    double bpt_insert_ns = bench_ns(start, n);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      checksum -= bpt_search(bpt, keys[(i * 7919) % n], &value);
+    }
+    double bpt_search_ns = bench_ns(start, n);
+    start = clock();
+    bpt_iter_t iter;
+    int64_t key;
+    bpt_iter_begin(&iter, bpt);
+    while (bpt_iter_next(&iter, &key, &value)) {
+      checksum -= value;
+    }
+    double bpt_scan = bench_ns(start, n);
+    start = clock();
+    for (long i = 0; i < n; i++) {
+      bpt_delete(&bpt, keys[i]);
+    }
+    double bpt_delete_ns = bench_ns(start, n);
+    printf("%9ld %-6s %9.1f %9.1f %9.1f %9.1f\n", n, "B+", bpt_insert_ns,
+           bpt_search_ns, bpt_scan, bpt_delete_ns);
+
+    if (checksum != 0 || bst != NULL || bpt != NULL) {
+      printf("[W] Results of the trees differ\n");
+    }
+    free(keys);
+  }
+  return 0;
+}
@@ -0,0 +1,402 @@
+/*
+ * B+ strom
+ *
+ * Uzly se rozdělují a slučují už při sestupu od kořene (jako v učebnici
+ * Cormen et al.), takže vložení i odstranění projde strom jen jednou
+ * a nepotřebuje zásobník rodičů. Výška stromu je logaritmus o základu
+ * BPT_KEYS/2, pro miliony klíčů tedy jen několik úrovní.
+ */
+
+#include "bplus.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#if BPT_KEYS > 64 || BPT_KEYS % 4 != 0
+#error "BPT_KEYS must be a multiple of 4 not greater than 64"
+#endif
+
+/*
+ * Pomocná funkce která vrátí počet klíčů uzlu menších než key (less) nebo
+ * menších nebo rovných key (!less).
+ *
+ * S AVX2 porovná celý uzel po čtyřech klíčích bez podmíněných skoků
+ * a výsledek omezí na platné klíče maskou, jinak porovná klíče postupně.
+ */
+static int bpt_node_rank(const bpt_node_t *node, int64_t key, bool less) {
+#ifdef __AVX2__
+  __m256i needle = _mm256_set1_epi64x(key);
+  uint64_t greater = 0; // bit i set when keys[i] > key
+  uint64_t smaller = 0; // bit i set when keys[i] < key
+  for (int i = 0; i < BPT_KEYS; i += 4) {
+    __m256i keys = _mm256_load_si256((const __m256i *)&node->keys[i]);
+    greater |= (uint64_t)_mm256_movemask_pd(
+                   _mm256_castsi256_pd(_mm256_cmpgt_epi64(keys, needle)))
+               << i;
+    smaller |= (uint64_t)_mm256_movemask_pd(
+                   _mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, keys)))
+               << i;
+  }
+  uint64_t valid =
+      node->count == 64 ? UINT64_MAX : ((uint64_t)1 << node->count) - 1;
+  if (less) {
+    return __builtin_popcountll(smaller & valid);
+  }
+  return node->count - __builtin_popcountll(greater & valid);
+#else
+  int rank = 0;
+  if (less) {
+    for (int i = 0; i < node->count; i++) {
+      rank += node->keys[i] < key;
+    }
+  } else {
+    for (int i = 0; i < node->count; i++) {
+      rank += node->keys[i] <= key;
+    }
+  }
+  return rank;
+#endif
+}
+
+/*
+ * Pomocná funkce pro alokaci prázdného uzlu zarovnaného na řádek cache.
+ */
+static bpt_node_t *bpt_node_new(bool leaf) {
+  size_t size = (sizeof(bpt_node_t) + 63) / 64 * 64;
+  bpt_node_t *node = aligned_alloc(64, size);
+  if (node == NULL) {
+    return NULL;
+  }
+  memset(node, 0, sizeof(bpt_node_t));
+  node->leaf = leaf;
+  return node;
+}
+
+/*
+ * Inicializace stromu.
+ */
+void bpt_init(bpt_node_t **tree) {
+  (*tree) = NULL;
+}
+
+/*
+ * Vyhledání klíče ve stromu.
+ *
+ * V případě úspěchu vrátí funkce hodnotu true a do proměnné value zapíše
+ * hodnotu klíče. V opačném případě vrátí false a value zůstává nezměněná.
+ */
+bool bpt_search(bpt_node_t *tree, int64_t key, int *value) {
+  if (tree == NULL) {
+    return false;
+  }
+
+  // Child i holds the keys from keys[i-1] (inclusive) up to keys[i].
+  while (!tree->leaf) {
+    tree = tree->children[bpt_node_rank(tree, key, false)];
+  }
+
+  int index = bpt_node_rank(tree, key, true);
+  if (index < tree->count && tree->keys[index] == key) {
+    *value = tree->values[index];
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Pomocná funkce která rozdělí plného potomka index uzlu parent na dva
+ * a oddělovací klíč vloží do parent. Uzel parent nesmí být plný.
+ */
+static bool bpt_split_child(bpt_node_t *parent, int index) {
+  bpt_node_t *child = parent->children[index];
+  bpt_node_t *sibling = bpt_node_new(child->leaf);
+  if (sibling == NULL) {
+    return false;
+  }
+
+  int64_t separator;
+  int mid = BPT_KEYS / 2;
+  if (child->leaf) {
+    // Leaves keep every key, the first right key is copied up.
+    sibling->count = BPT_KEYS - mid;
+    memcpy(sibling->keys, &child->keys[mid], sibling->count * sizeof(int64_t));
+    memcpy(sibling->values, &child->values[mid], sibling->count * sizeof(int));
+    sibling->next = child->next;
+    child->next = sibling;
+    separator = sibling->keys[0];
+  } else {
+    // Inner nodes move the middle key up.
+    sibling->count = BPT_KEYS - mid - 1;
+    memcpy(sibling->keys, &child->keys[mid + 1],
+           sibling->count * sizeof(int64_t));
+    memcpy(sibling->children, &child->children[mid + 1],
+           (sibling->count + 1) * sizeof(bpt_node_t *));
+    separator = child->keys[mid];
+  }
+  child->count = mid;
+
+  memmove(&parent->keys[index + 1], &parent->keys[index],
+          (parent->count - index) * sizeof(int64_t));
+  memmove(&parent->children[index + 2], &parent->children[index + 1],
+          (parent->count - index) * sizeof(bpt_node_t *));
+  parent->keys[index] = separator;
+  parent->children[index + 1] = sibling;
+  parent->count++;
+  return true;
+}
+
+/*
+ * Vložení klíče do stromu.
+ *
+ * Pokud klíč už ve stromu existuje, nahradí se jeho hodnota. Plné uzly se
+ * rozdělí už při sestupu, takže pro nový klíč je v listu vždy místo.
+ */
+void bpt_insert(bpt_node_t **tree, int64_t key, int value) {
+  if ((*tree) == NULL) {
+    (*tree) = bpt_node_new(true);
+    if ((*tree) == NULL) {
+      return;
+    }
+  }
+
+  if ((*tree)->count == BPT_KEYS) { // Full root, the tree grows by a level.
+    bpt_node_t *root = bpt_node_new(false);
+    if (root == NULL) {
+      return;
+    }
+    root->children[0] = (*tree);
+    if (!bpt_split_child(root, 0)) {
+      free(root);
+      return;
+    }
+    (*tree) = root;
+  }
+
+  bpt_node_t *node = (*tree);
+  while (!node->leaf) {
+    int index = bpt_node_rank(node, key, false);
+    if (node->children[index]->count == BPT_KEYS) {
+      if (!bpt_split_child(node, index)) {
+        return;
+      }
+      if (key >= node->keys[index]) {
+        index++;
+      }
+    }
+    node = node->children[index];
+  }
+
+  int index = bpt_node_rank(node, key, true);
+  if (index < node->count && node->keys[index] == key) {
+    node->values[index] = value;
+    return;
+  }
+  memmove(&node->keys[index + 1], &node->keys[index],
+          (node->count - index) * sizeof(int64_t));
+  memmove(&node->values[index + 1], &node->values[index],
+          (node->count - index) * sizeof(int));
+  node->keys[index] = key;
+  node->values[index] = value;
+  node->count++;
+}
+
+/*
+ * Pomocná funkce která sloučí potomky index a index+1 uzlu parent do
+ * potomka index. Součet jejich klíčů se musí vejít do jednoho uzlu.
+ */
+static void bpt_merge_children(bpt_node_t *parent, int index) {
+  bpt_node_t *left = parent->children[index];
+  bpt_node_t *right = parent->children[index + 1];
+
+  if (left->leaf) {
+    memcpy(&left->keys[left->count], right->keys,
+           right->count * sizeof(int64_t));
+    memcpy(&left->values[left->count], right->values,
+           right->count * sizeof(int));
+    left->count += right->count;
+    left->next = right->next;
+  } else {
+    // The separator comes down between the two halves.
+    left->keys[left->count] = parent->keys[index];
+    memcpy(&left->keys[left->count + 1], right->keys,
+           right->count * sizeof(int64_t));
+    memcpy(&left->children[left->count + 1], right->children,
+           (right->count + 1) * sizeof(bpt_node_t *));
+    left->count += right->count + 1;
+  }
+  free(right);
+
+  memmove(&parent->keys[index], &parent->keys[index + 1],
+          (parent->count - index - 1) * sizeof(int64_t));
+  memmove(&parent->children[index + 1], &parent->children[index + 2],
+          (parent->count - index - 1) * sizeof(bpt_node_t *));
+  parent->count--;
+}
+
+/*
+ * Pomocná funkce která přesune jeden klíč z levého sourozence do potomka
+ * index uzlu parent.
+ */
+static void bpt_borrow_left(bpt_node_t *parent, int index) {
+  bpt_node_t *child = parent->children[index];
+  bpt_node_t *left = parent->children[index - 1];
+
+  memmove(&child->keys[1], child->keys, child->count * sizeof(int64_t));
+  if (child->leaf) {
+    memmove(&child->values[1], child->values, child->count * sizeof(int));
+    child->keys[0] = left->keys[left->count - 1];
+    child->values[0] = left->values[left->count - 1];
+    parent->keys[index - 1] = child->keys[0];
+  } else {
+    memmove(&child->children[1], child->children,
+            (child->count + 1) * sizeof(bpt_node_t *));
+    child->keys[0] = parent->keys[index - 1];
+    child->children[0] = left->children[left->count];
+    parent->keys[index - 1] = left->keys[left->count - 1];
+  }
+  child->count++;
+  left->count--;
+}
+
+/*
+ * Pomocná funkce která přesune jeden klíč z pravého sourozence do potomka
+ * index uzlu parent.
+ */
+static void bpt_borrow_right(bpt_node_t *parent, int index) {
+  bpt_node_t *child = parent->children[index];
+  bpt_node_t *right = parent->children[index + 1];
+
+  if (child->leaf) {
+    child->keys[child->count] = right->keys[0];
+    child->values[child->count] = right->values[0];
+    memmove(right->values, &right->values[1],
+            (right->count - 1) * sizeof(int));
+    memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(int64_t));
+    parent->keys[index] = right->keys[0];
+  } else {
+    child->keys[child->count] = parent->keys[index];
+    child->children[child->count + 1] = right->children[0];
+    parent->keys[index] = right->keys[0];
+    memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(int64_t));
+    memmove(right->children, &right->children[1],
+            right->count * sizeof(bpt_node_t *));
+  }
+  child->count++;
+  right->count--;
+}
+
+/*
+ * Odstranění klíče ze stromu.
+ *
+ * Pokud klíč neexistuje, funkce strom nemění (kromě případného vyrovnání
+ * uzlů na cestě). Před sestupem do potomka s minimálním počtem klíčů si
+ * potomek klíč vypůjčí od sourozence, nebo se s ním sloučí, takže odebrání
+ * klíče z listu už nic dalšího nevyžaduje.
+ */
+void bpt_delete(bpt_node_t **tree, int64_t key) {
+  if ((*tree) == NULL) {
+    return;
+  }
+
+  bpt_node_t *node = (*tree);
+  while (!node->leaf) {
+    int index = bpt_node_rank(node, key, false);
+    if (node->children[index]->count <= BPT_MIN_KEYS) {
+      if (index > 0 && node->children[index - 1]->count > BPT_MIN_KEYS) {
+        bpt_borrow_left(node, index);
+      } else if (index < node->count &&
+                 node->children[index + 1]->count > BPT_MIN_KEYS) {
+        bpt_borrow_right(node, index);
+      } else if (index < node->count) {
+        bpt_merge_children(node, index);
+      } else {
+        bpt_merge_children(node, index - 1);
+        index--;
+      }
+    }
+
+    // A root left without keys is replaced by its only child.
+    if (node == (*tree) && node->count == 0) {
+      (*tree) = node->children[0];
+      free(node);
+      node = (*tree);
+      continue;
+    }
+    node = node->children[index];
+  }
+
+  int index = bpt_node_rank(node, key, true);
+  if (index < node->count && node->keys[index] == key) {
+    memmove(&node->keys[index], &node->keys[index + 1],
+            (node->count - index - 1) * sizeof(int64_t));
+    memmove(&node->values[index], &node->values[index + 1],
+            (node->count - index - 1) * sizeof(int));
+    node->count--;
+  }
+
+  if ((*tree)->leaf && (*tree)->count == 0) {
+    free(*tree);
+    (*tree) = NULL;
+  }
+}
+
+/*
+ * Zrušení celého stromu.
+ */
+void bpt_dispose(bpt_node_t **tree) {
+  if ((*tree) == NULL) {
+    return;
+  }
+  if (!(*tree)->leaf) {
+    for (int i = 0; i <= (*tree)->count; i++) {
+      bpt_dispose(&((*tree)->children[i]));
+    }
+  }
+  free(*tree);
+  (*tree) = NULL;
+}
+
+/*
+ * Nastavení iterátoru na nejmenší klíč stromu.
+ */
+void bpt_iter_begin(bpt_iter_t *iter, bpt_node_t *tree) {
+  while (tree != NULL && !tree->leaf) {
+    tree = tree->children[0];
+  }
+  iter->leaf = tree;
+  iter->index = 0;
+}
+
+/*
+ * Nastavení iterátoru na první klíč větší nebo rovný key.
+ */
+void bpt_iter_seek(bpt_iter_t *iter, bpt_node_t *tree, int64_t key) {
+  while (tree != NULL && !tree->leaf) {
+    tree = tree->children[bpt_node_rank(tree, key, false)];
+  }
+  iter->leaf = tree;
+  iter->index = tree != NULL ? bpt_node_rank(tree, key, true) : 0;
+}
+
+/*
+ * Přečtení dalšího klíče a hodnoty.
+ *
+ * Vrací false, pokud už žádný klíč nezbývá. Po seřazených listech se
+ * postupuje přes ukazatel next, vnitřní uzly se znovu nenavštěvují.
+ */
+bool bpt_iter_next(bpt_iter_t *iter, int64_t *key, int *value) {
+  while (iter->leaf != NULL && iter->index >= iter->leaf->count) {
+    iter->leaf = iter->leaf->next;
+    iter->index = 0;
+  }
+  if (iter->leaf == NULL) {
+    return false;
+  }
+  *key = iter->leaf->keys[iter->index];
+  *value = iter->leaf->values[iter->index];
+  iter->index++;
+  return true;
+}
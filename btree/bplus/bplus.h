@@ -0,0 +1,51 @@
+/*
+ * Hlavičkový soubor pro B+ strom.
+ *
+ * Na rozdíl od binárního stromu z btree.h obsahuje každý uzel až BPT_KEYS
+ * seřazených klíčů, takže jeden přístup do paměti odbaví několik úrovní
+ * binárního stromu. Hodnoty jsou uložené jen v listech, které jsou navíc
+ * propojené do seznamu pro rychlý průchod podle pořadí klíčů.
+ */
+
+#ifndef IAL_BTREE_BPLUS_H
+#define IAL_BTREE_BPLUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Maximální počet klíčů v uzlu (násobek 4 kvůli SIMD porovnání)
+#define BPT_KEYS 32
+// Minimální počet klíčů v uzlu, který není kořenem
+#define BPT_MIN_KEYS (BPT_KEYS / 2 - 1)
+
+// Uzel B+ stromu
+typedef struct bpt_node {
+  int64_t keys[BPT_KEYS];                    // seřazené klíče
+  int count;                                 // počet klíčů
+  bool leaf;                                 // jde o list
+  union {
+    struct bpt_node *children[BPT_KEYS + 1]; // potomci vnitřního uzlu
+    struct {
+      int values[BPT_KEYS];                  // hodnoty listu
+      struct bpt_node *next;                 // následující list
+    };
+  };
+} bpt_node_t;
+
+void bpt_init(bpt_node_t **tree);
+void bpt_insert(bpt_node_t **tree, int64_t key, int value);
+bool bpt_search(bpt_node_t *tree, int64_t key, int *value);
+void bpt_delete(bpt_node_t **tree, int64_t key);
+void bpt_dispose(bpt_node_t **tree);
+
+// Iterátor procházející listy podle pořadí klíčů
+typedef struct bpt_iter {
+  bpt_node_t *leaf;       // aktuální list
+  int index;              // index dalšího klíče v listu
+} bpt_iter_t;
+
+void bpt_iter_begin(bpt_iter_t *iter, bpt_node_t *tree);
+void bpt_iter_seek(bpt_iter_t *iter, bpt_node_t *tree, int64_t key);
+bool bpt_iter_next(bpt_iter_t *iter, int64_t *key, int *value);
+
+#endif
@@ -0,0 +1,132 @@
+#include "bplus.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST(NAME, DESCRIPTION)                                                \
+  void NAME() {                                                                \
+    printf("[%s] %s\n", #NAME, DESCRIPTION);                                   \
+    bpt_node_t *test_tree;
+
+#define ENDTEST                                                                \
+  printf("\n");                                                                \
+  bpt_dispose(&test_tree);                                                     \
+  }
+
+const int test_data_count = 1000;
+
+void init_test() {
+  printf("B+ Tree - testing script\n");
+  printf("------------------------\n");
+  printf("\n");
+}
+
+/*
+ * Ověří uspořádání klíčů, zaplnění uzlů a stejnou hloubku listů a vrátí
+ * hloubku listů, nebo -1 při porušení některé podmínky.
+ */
+int bpt_check_subtree(bpt_node_t *node, bool root, int64_t lo, int64_t hi) {
+  if (node->count > BPT_KEYS || (!root && node->count < BPT_MIN_KEYS)) {
+    return -1;
+  }
+  for (int i = 0; i < node->count; i++) {
+    if (node->keys[i] < lo || node->keys[i] >= hi ||
+        (i > 0 && node->keys[i - 1] >= node->keys[i])) {
+      return -1;
+    }
+  }
+  if (node->leaf) {
+    return 0;
+  }
+  int depth = -1;
+  for (int i = 0; i <= node->count; i++) {
+    int64_t child_lo = i > 0 ? node->keys[i - 1] : lo;
+    int64_t child_hi = i < node->count ? node->keys[i] : hi;
+    int child_depth =
+        bpt_check_subtree(node->children[i], false, child_lo, child_hi);
+    if (child_depth < 0 || (depth >= 0 && child_depth + 1 != depth)) {
+      return -1;
+    }
+    depth = child_depth + 1;
+  }
+  return depth;
+}
+
+void bpt_print_check(bpt_node_t *tree) {
+  int height = 0;
+  if (tree != NULL) {
+    int depth = bpt_check_subtree(tree, true, INT64_MIN, INT64_MAX);
+    height = depth >= 0 ? depth + 1 : -1;
+  }
+  printf("Tree valid: %s, height: %d\n", height >= 0 ? "yes" : "no", height);
+}
+
+void bpt_print_range(bpt_node_t *tree, int64_t lo, int count) {
+  bpt_iter_t iter;
+  int64_t key;
+  int value;
+  bpt_iter_seek(&iter, tree, lo);
+  printf("Traversed items:\n");
+  for (int i = 0; i < count && bpt_iter_next(&iter, &key, &value); i++) {
+    printf("[%lld,%d]", (long long)key, value);
+  }
+  printf("\n");
+}
+
+TEST(test_tree_search_empty, "Search in an empty tree (1)")
+bpt_init(&test_tree);
+int value = -1;
+bool found = bpt_search(test_tree, 1, &value);
+printf("Found: %d %d\n", found, value);
+ENDTEST
+
+TEST(test_tree_insert_many, "Insert many values in shuffled order")
+bpt_init(&test_tree);
+for (int i = 0; i < test_data_count; i++) {
+  int64_t key = (int64_t)i * 7919 % test_data_count;
+  bpt_insert(&test_tree, key * 10, (int)key);
+}
+bpt_print_check(test_tree);
+bpt_print_range(test_tree, 0, 10);
+bpt_print_range(test_tree, 4995, 5);
+ENDTEST
+
+TEST(test_tree_search, "Search for present and missing keys (500, 505)")
+bpt_init(&test_tree);
+for (int i = 0; i < test_data_count; i++) {
+  bpt_insert(&test_tree, (int64_t)i * 10, i);
+}
+bpt_insert(&test_tree, 500, -50);
+int value = -1;
+bool found = bpt_search(test_tree, 500, &value);
+printf("Found: %d %d\n", found, value);
+value = -1;
+found = bpt_search(test_tree, 505, &value);
+printf("Found: %d %d\n", found, value);
+ENDTEST
+
+TEST(test_tree_delete, "Delete every second key, then all keys")
+bpt_init(&test_tree);
+for (int i = 0; i < test_data_count; i++) {
+  bpt_insert(&test_tree, i, i);
+}
+for (int i = 0; i < test_data_count; i += 2) {
+  bpt_delete(&test_tree, i);
+}
+bpt_delete(&test_tree, test_data_count + 1);
+bpt_print_check(test_tree);
+bpt_print_range(test_tree, 490, 5);
+for (int i = test_data_count - 1; i >= 0; i--) {
+  bpt_delete(&test_tree, i);
+}
+bpt_print_check(test_tree);
+printf("Tree is empty: %s\n", test_tree == NULL ? "yes" : "no");
+ENDTEST
+
+int main(int argc, char *argv[]) {
+  init_test();
+
+  test_tree_search_empty();
+  test_tree_insert_many();
+  test_tree_search();
+  test_tree_delete();
+}
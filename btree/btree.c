@@ -1,6 +1,8 @@
 #include "btree.h"
+#include "gen/bst_gen.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*
  * Pomocná funkce která vypíše uzel stromu.
@@ -21,3 +23,1658 @@ void bst_add_node_to_items(bst_node_t* node, bst_items_t *items) {
   items->nodes[items->size] = node;
   items->size++;
 }
+
+/*
+ * Pomocná funkce která vloží uzel na zásobník iterátoru.
+ *
+ * Zásobník začíná v poli uvnitř iterátoru, na haldu se přesune až ve chvíli,
+ * kdy výška stromu přesáhne BST_ITER_STACK. Velikost zásobníku je tedy
+ * omezená výškou stromu, nikoliv počtem uzlů. Pokud se zásobník nepodaří
+ * zvětšit, nastaví iter->failed a průchod tím skončí.
+ */
+static void bst_iter_push(bst_iter_t *iter, bst_node_t *node) {
+  if (iter->top == iter->capacity - 1) {
+    int capacity = iter->capacity * 2;
+    bst_node_t **nodes;
+    if (iter->nodes == iter->inline_nodes) {
+      nodes = malloc(capacity * sizeof(bst_node_t *));
+      if (nodes != NULL) {
+        for (int i = 0; i <= iter->top; i++) {
+          nodes[i] = iter->inline_nodes[i];
+        }
+      }
+    } else {
+      nodes = realloc(iter->nodes, capacity * sizeof(bst_node_t *));
+    }
+    if (nodes == NULL) {
+      iter->failed = true;
+      return;
+    }
+    iter->nodes = nodes;
+    iter->capacity = capacity;
+  }
+  iter->nodes[++iter->top] = node;
+}
+
+/*
+ * Pomocná funkce pro postorder iterátor.
+ *
+ * Sestupuje z uzlu k prvnímu listu v pořadí postorder (doleva, pokud to jde,
+ * jinak doprava) a ukládá všechny uzly cesty na zásobník.
+ */
+static void bst_iter_leftmost_leaf(bst_iter_t *iter, bst_node_t *tree) {
+  while (tree != NULL) {
+    bst_iter_push(iter, tree);
+    tree = tree->left != NULL ? tree->left : tree->right;
+  }
+}
+
+/*
+ * Pomocná funkce pro inorder iterátor.
+ *
+ * Sestupuje po levé větvi k nejlevějšímu uzlu podstromu a ukládá uzly na
+ * zásobník.
+ */
+static void bst_iter_leftmost(bst_iter_t *iter, bst_node_t *tree) {
+  while (tree != NULL) {
+    bst_iter_push(iter, tree);
+    tree = tree->left;
+  }
+}
+
+/*
+ * Pomocná funkce která připraví prázdný iterátor nad stromem.
+ */
+static void bst_iter_init(bst_iter_t *iter, bst_node_t *tree,
+                          bst_iter_order_t order) {
+  iter->root = tree;
+  iter->order = order;
+  iter->nodes = iter->inline_nodes;
+  iter->capacity = BST_ITER_STACK;
+  iter->top = -1;
+  iter->failed = false;
+}
+
+/*
+ * Inicializace inorder iterátoru.
+ *
+ * Iterátor vrací uzly postupně funkcí bst_iter_next, takže průchod lze
+ * kdykoliv ukončit bez materializace všech uzlů do bst_items_t. Během
+ * iterace se strom nesmí měnit a iterátor se nesmí kopírovat. Po použití je
+ * nutné zavolat bst_iter_end.
+ *
+ * Pokud se nepodaří alokovat zásobník pro vysoký strom, bst_iter_next
+ * vrátí NULL dříve, než průchod skončí, a iter->failed je true. Volající
+ * proto po průchodu kontroluje iter->failed.
+ */
+void bst_iter_begin(bst_iter_t *iter, bst_node_t *tree) {
+  bst_iter_init(iter, tree, BST_ITER_INORDER);
+  bst_iter_leftmost(iter, tree);
+}
+
+/*
+ * Inicializace preorder iterátoru.
+ */
+void bst_iter_begin_preorder(bst_iter_t *iter, bst_node_t *tree) {
+  bst_iter_init(iter, tree, BST_ITER_PREORDER);
+  if (tree != NULL) {
+    bst_iter_push(iter, tree);
+  }
+}
+
+/*
+ * Inicializace postorder iterátoru.
+ */
+void bst_iter_begin_postorder(bst_iter_t *iter, bst_node_t *tree) {
+  bst_iter_init(iter, tree, BST_ITER_POSTORDER);
+  bst_iter_leftmost_leaf(iter, tree);
+}
+
+/*
+ * Přesun iterátoru na první uzel s klíčem větším nebo rovným key.
+ *
+ * Iterátor se přepne do režimu inorder, další volání bst_iter_next tedy
+ * vrátí nalezený uzel a po něm uzly s většími klíči. Cena je O(výška).
+ */
+void bst_iter_seek(bst_iter_t *iter, char key) {
+  iter->order = BST_ITER_INORDER;
+  iter->top = -1;
+  iter->failed = false;
+
+  // Only the nodes where the search turns left are still to be visited.
+  bst_node_t *tree = iter->root;
+  while (tree != NULL) {
+    if (key <= tree->key) {
+      bst_iter_push(iter, tree);
+      tree = tree->left;
+    } else {
+      tree = tree->right;
+    }
+  }
+}
+
+/*
+ * Vrátí další uzel průchodu, nebo NULL, pokud průchod skončil nebo selhala
+ * alokace zásobníku (iter->failed).
+ */
+bst_node_t *bst_iter_next(bst_iter_t *iter) {
+  if (iter->top == -1 || iter->failed) {
+    return NULL;
+  }
+
+  bst_node_t *node = iter->nodes[iter->top--];
+
+  switch (iter->order) {
+  case BST_ITER_PREORDER:
+    // Push right first, so the left subtree is visited before it.
+    if (node->right != NULL) {
+      bst_iter_push(iter, node->right);
+    }
+    if (node->left != NULL) {
+      bst_iter_push(iter, node->left);
+    }
+    break;
+
+  case BST_ITER_INORDER:
+    bst_iter_leftmost(iter, node->right);
+    break;
+
+  case BST_ITER_POSTORDER:
+    // Coming up from the left child, the right subtree is still pending.
+    if (iter->top != -1) {
+      bst_node_t *parent = iter->nodes[iter->top];
+      if (parent->left == node) {
+        bst_iter_leftmost_leaf(iter, parent->right);
+      }
+    }
+    break;
+  }
+
+  return iter->failed ? NULL : node;
+}
+
+/*
+ * Ukončení iterace a uvolnění zásobníku, pokud byl přesunut na haldu.
+ * Příznak iter->failed zůstane zachován.
+ */
+void bst_iter_end(bst_iter_t *iter) {
+  if (iter->nodes != iter->inline_nodes) {
+    free(iter->nodes);
+  }
+  iter->nodes = iter->inline_nodes;
+  iter->capacity = BST_ITER_STACK;
+  iter->top = -1;
+}
+
+_Thread_local bst_pool_t *BST_POOL = NULL;
+
+/*
+ * Inicializace poolu uzlů velikosti node_size.
+ *
+ * Pool přiděluje uzly ze souvislých bloků, takže uzly vložené po sobě leží
+ * v paměti vedle sebe. Uvolněné uzly se vrací do seznamu volných uzlů a
+ * přidělí se znovu.
+ */
+void bst_pool_init(bst_pool_t *pool, size_t node_size) {
+  // Every node must be able to hold the free list link.
+  if (node_size < sizeof(void *)) {
+    node_size = sizeof(void *);
+  }
+  node_size = (node_size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+  pool->node_size = node_size;
+  pool->slab_nodes = BST_POOL_SLAB;
+  pool->slabs = NULL;
+  pool->free_nodes = NULL;
+  pool->next = NULL;
+  pool->end = NULL;
+}
+
+/*
+ * Přidělení uzlu z poolu.
+ *
+ * V případě chyby alokace vrací NULL.
+ */
+void *bst_pool_alloc(bst_pool_t *pool) {
+  // Recycle a freed node first.
+  if (pool->free_nodes != NULL) {
+    void *node = pool->free_nodes;
+    pool->free_nodes = *(void **)node;
+    return node;
+  }
+
+  if (pool->next == pool->end) {
+    bst_pool_slab_t *slab =
+        malloc(sizeof(bst_pool_slab_t) + pool->slab_nodes * pool->node_size);
+    if (slab == NULL) {
+      return NULL;
+    }
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->next = (char *)slab->nodes;
+    pool->end = pool->next + pool->slab_nodes * pool->node_size;
+
+    if (pool->slab_nodes < BST_POOL_SLAB_MAX) {
+      pool->slab_nodes *= 2;
+    }
+  }
+
+  void *node = pool->next;
+  pool->next += pool->node_size;
+  return node;
+}
+
+/*
+ * Vrácení uzlu do poolu, ze kterého byl přidělen.
+ */
+void bst_pool_free(bst_pool_t *pool, void *node) {
+  *(void **)node = pool->free_nodes;
+  pool->free_nodes = node;
+}
+
+/*
+ * Zrušení poolu.
+ *
+ * Uvolní všechny bloky najednou v čase O(počet bloků), tedy bez procházení
+ * uzlů. Všechny stromy s uzly z poolu tím zaniknou a jejich kořeny je nutné
+ * znovu inicializovat funkcí bst_init. Pool zůstane ve stavu po inicializaci.
+ */
+void bst_pool_dispose(bst_pool_t *pool) {
+  while (pool->slabs != NULL) {
+    bst_pool_slab_t *next = pool->slabs->next;
+    free(pool->slabs);
+    pool->slabs = next;
+  }
+  bst_pool_init(pool, pool->node_size);
+}
+
+/*
+ * Pomocná funkce pro alokaci uzlu stromu z BST_POOL, případně funkcí malloc.
+ */
+bst_node_t *bst_node_alloc(void) {
+  bst_node_t *node;
+  if (BST_POOL != NULL) {
+    node = bst_pool_alloc(BST_POOL);
+  } else {
+    node = malloc(sizeof(bst_node_t));
+  }
+  if (node == NULL) {
+    return NULL;
+  }
+  // Only successful allocations count, bst_node_free pairs with them.
+  BST_STATS_MEMORY(true);
+#ifdef BST_PERSISTENT
+  // Any tree may become a version, bst_dispose only drops this reference.
+  atomic_init(&node->refs, 1);
+#endif
+  return node;
+}
+
+/*
+ * Pomocná funkce pro uvolnění uzlu alokovaného funkcí bst_node_alloc.
+ *
+ * BST_POOL se nesmí změnit, dokud existují uzly alokované z předchozího
+ * poolu, a uzel musí uvolnit stejné vlákno, které ho alokovalo z poolu.
+ */
+void bst_node_free(bst_node_t *node) {
+  BST_STATS_MEMORY(false);
+  if (BST_POOL != NULL) {
+    bst_pool_free(BST_POOL, node);
+  } else {
+    free(node);
+  }
+}
+
+/*
+ * Zmrazení stromu pro vyhledávání.
+ *
+ * Uloží klíče a hodnoty stromu do polí bez ukazatelů v pořadí Eytzinger,
+ * tedy jako úplný binární strom uložený po úrovních. Funkce
+ * bst_frozen_search vrací stejné výsledky jako bst_search nad původním
+ * stromem, ale uzly cesty leží v paměti blízko sebe, porovnání se
+ * vyhodnocuje bez podmíněných skoků a další úrovně se přednačítají. Strom
+ * se nemění, změny stromu po zmrazení se ale do zmrazené kopie
+ * nepromítnou. Zmrazený strom se uvolní funkcí bst_frozen_dispose.
+ */
+BSTDEF_FROZEN(char, int, bst, BST_CMP_SCALAR)
+
+/*
+ * Dávkové vyhledávání n klíčů, viz BSTDEF_BATCH v gen/bst_gen.h.
+ *
+ * V režimu BST_SPLAY se strom nemění, uzly se tedy do kořene nepřesunou.
+ */
+BSTDEF_BATCH(char, int, bst, BST_CMP_SCALAR)
+
+/*
+ * Inicializace kompaktního stromu.
+ *
+ * Kompaktní strom má stejné chování jako strom z rec/iter variant (včetně
+ * tvaru po odstranění uzlu), uzly ale leží v jednom poli a místo
+ * ukazatelů obsahují 32bitové indexy. Uzel tak zabírá 12 bajtů a klíč
+ * 1 bajt v samostatném poli klíčů, místo 24 bajtů uzlu bst_node_t
+ * a hlavičky malloc. Klíče, které hledání porovnává, leží hustě vedle
+ * sebe. Ukazatele na uzly nejsou stálé, pole se při růstu přesouvá.
+ * Strom pojme nejvýše BST_COMPACT_MAX uzlů, další vložení selže stejně
+ * jako při chybě alokace.
+ */
+void bst_compact_init(bst_compact_t *tree) {
+  tree->keys = NULL;
+  tree->nodes = NULL;
+  tree->root = BST_COMPACT_NIL;
+  tree->free = BST_COMPACT_NIL;
+  tree->used = 0;
+  tree->capacity = 0;
+}
+
+/*
+ * Vyhledání uzlu v kompaktním stromu, viz bst_search.
+ */
+bool bst_compact_search(bst_compact_t *tree, char key, int *value) {
+  uint32_t node = tree->root;
+  while (node != BST_COMPACT_NIL) {
+    char node_key = tree->keys[node];
+    if (node_key == key) {
+      *value = tree->nodes[node].value;
+      return true;
+    }
+    node = key < node_key ? tree->nodes[node].left : tree->nodes[node].right;
+  }
+  return false;
+}
+
+/*
+ * Pomocná funkce která vrátí index volného uzlu, nebo BST_COMPACT_NIL,
+ * pokud se nepodaří zvětšit pole.
+ */
+static uint32_t bst_compact_alloc(bst_compact_t *tree) {
+  if (tree->free != BST_COMPACT_NIL) {
+    uint32_t node = tree->free;
+    tree->free = tree->nodes[node].left;
+    return node;
+  }
+  if (tree->used == tree->capacity) {
+    // Past BST_COMPACT_MAX an index could overflow or equal the NIL marker.
+    if (tree->capacity >= BST_COMPACT_MAX) {
+      return BST_COMPACT_NIL;
+    }
+    uint32_t capacity = tree->capacity > (BST_COMPACT_MAX - 8) / 2
+                            ? BST_COMPACT_MAX
+                            : tree->capacity * 2 + 8;
+    if (capacity > SIZE_MAX / sizeof(bst_compact_node_t)) {
+      return BST_COMPACT_NIL;
+    }
+    char *keys = realloc(tree->keys, capacity);
+    if (keys == NULL) {
+      return BST_COMPACT_NIL;
+    }
+    tree->keys = keys;
+    bst_compact_node_t *nodes =
+        realloc(tree->nodes, capacity * sizeof(bst_compact_node_t));
+    if (nodes == NULL) {
+      return BST_COMPACT_NIL;
+    }
+    tree->nodes = nodes;
+    tree->capacity = capacity;
+  }
+  return tree->used++;
+}
+
+/*
+ * Vložení uzlu do kompaktního stromu, viz bst_insert.
+ */
+void bst_compact_insert(bst_compact_t *tree, char key, int value) {
+  uint32_t parent = BST_COMPACT_NIL;
+  uint32_t node = tree->root;
+  while (node != BST_COMPACT_NIL) {
+    if (tree->keys[node] == key) {
+      tree->nodes[node].value = value;
+      return;
+    }
+    parent = node;
+    node = key < tree->keys[node] ? tree->nodes[node].left
+                                  : tree->nodes[node].right;
+  }
+
+  // The arrays may move, so the parent is linked by its index.
+  node = bst_compact_alloc(tree);
+  if (node == BST_COMPACT_NIL) {
+    return;
+  }
+  tree->keys[node] = key;
+  tree->nodes[node].left = BST_COMPACT_NIL;
+  tree->nodes[node].right = BST_COMPACT_NIL;
+  tree->nodes[node].value = value;
+  if (parent == BST_COMPACT_NIL) {
+    tree->root = node;
+  } else if (key < tree->keys[parent]) {
+    tree->nodes[parent].left = node;
+  } else {
+    tree->nodes[parent].right = node;
+  }
+}
+
+/*
+ * Odstranění uzlu z kompaktního stromu, viz bst_delete.
+ *
+ * Uzel se dvěma potomky se nahradí nejpravějším uzlem levého podstromu.
+ * Uvolněný uzel se vrátí do seznamu volných uzlů, pole se nezmenšuje.
+ */
+void bst_compact_delete(bst_compact_t *tree, char key) {
+  uint32_t *link = &tree->root;
+  while (*link != BST_COMPACT_NIL && tree->keys[*link] != key) {
+    bst_compact_node_t *node = &tree->nodes[*link];
+    link = key < tree->keys[*link] ? &node->left : &node->right;
+  }
+  if (*link == BST_COMPACT_NIL) {
+    return;
+  }
+
+  uint32_t removed = *link;
+  bst_compact_node_t *node = &tree->nodes[removed];
+  if (node->left == BST_COMPACT_NIL) {
+    *link = node->right;
+  } else if (node->right == BST_COMPACT_NIL) {
+    *link = node->left;
+  } else {
+    uint32_t *rightmost = &node->left;
+    while (tree->nodes[*rightmost].right != BST_COMPACT_NIL) {
+      rightmost = &tree->nodes[*rightmost].right;
+    }
+    tree->keys[removed] = tree->keys[*rightmost];
+    node->value = tree->nodes[*rightmost].value;
+    removed = *rightmost;
+    *rightmost = tree->nodes[removed].left;
+  }
+  tree->nodes[removed].left = tree->free;
+  tree->free = removed;
+}
+
+/*
+ * Zrušení kompaktního stromu, strom je pak ve stavu po inicializaci.
+ */
+void bst_compact_dispose(bst_compact_t *tree) {
+  free(tree->keys);
+  free(tree->nodes);
+  bst_compact_init(tree);
+}
+
+/*
+ * Pomocná funkce která uloží podstrom do kompaktního stromu v pořadí
+ * preorder a vrátí index jeho kořene.
+ */
+static uint32_t bst_compact_pack_subtree(bst_compact_t *compact,
+                                         bst_node_t *tree) {
+  if (tree == NULL) {
+    return BST_COMPACT_NIL;
+  }
+  uint32_t node = compact->used++;
+  compact->keys[node] = tree->key;
+  compact->nodes[node].value = tree->value;
+  compact->nodes[node].left = bst_compact_pack_subtree(compact, tree->left);
+  compact->nodes[node].right = bst_compact_pack_subtree(compact, tree->right);
+  return node;
+}
+
+/*
+ * Převod stromu na kompaktní strom stejného tvaru.
+ *
+ * Kompaktní strom compact musí být inicializovaný. Uzly se uloží v pořadí
+ * preorder, levý potomek tedy leží hned za svým rodičem. Původní strom
+ * se nemění.
+ */
+void bst_compact_pack(bst_compact_t *compact, bst_node_t *tree) {
+  bst_compact_dispose(compact);
+  uint32_t count = (uint32_t)bst_count_nodes(tree);
+  if (count == 0) {
+    return;
+  }
+  compact->keys = malloc(count);
+  compact->nodes = malloc(count * sizeof(bst_compact_node_t));
+  if (compact->keys == NULL || compact->nodes == NULL) {
+    bst_compact_dispose(compact);
+    return;
+  }
+  compact->capacity = count;
+  compact->root = bst_compact_pack_subtree(compact, tree);
+}
+
+/*
+ * Pomocná funkce která vytvoří strom z podstromu kompaktního stromu.
+ */
+static bst_node_t *bst_compact_unpack_subtree(bst_compact_t *compact,
+                                              uint32_t node) {
+  if (node == BST_COMPACT_NIL) {
+    return NULL;
+  }
+  bst_node_t *tree = bst_node_alloc();
+  if (tree == NULL) {
+    return NULL;
+  }
+  tree->key = compact->keys[node];
+  tree->value = compact->nodes[node].value;
+  tree->left = bst_compact_unpack_subtree(compact, compact->nodes[node].left);
+  tree->right = bst_compact_unpack_subtree(compact, compact->nodes[node].right);
+  BST_UPDATE_SIZE(tree);
+  return tree;
+}
+
+/*
+ * Převod kompaktního stromu na strom stejného tvaru z uzlů bst_node_t.
+ *
+ * Kompaktní strom se nemění. Výsledný strom se uvolní funkcí bst_dispose.
+ */
+bst_node_t *bst_compact_unpack(bst_compact_t *compact) {
+  return bst_compact_unpack_subtree(compact, compact->root);
+}
+
+/*
+ * Pomocná funkce která vrátí počet uzlů podstromu.
+ */
+int bst_count_nodes(bst_node_t *node) {
+  if (node == NULL) {
+    return 0;
+  }
+  return bst_count_nodes(node->left) + bst_count_nodes(node->right) + 1;
+}
+
+// Uzel na zásobníku bst_height
+typedef struct bst_height_frame {
+  bst_node_t *node;       // uzel
+  int depth;              // hloubka uzlu, kořen má hloubku 1
+} bst_height_frame_t;
+
+/*
+ * Výška stromu (kořen má výšku 1, prázdný strom 0), nebo -1, pokud se
+ * nepodaří alokovat zásobník.
+ *
+ * Strom se prochází v pořadí preorder, každý uzel na zásobníku nese svou
+ * hloubku. Zásobník začíná v poli na zásobníku volání a na haldu se
+ * přesune, až když přesáhne BST_ITER_STACK uzlů.
+ */
+int bst_height(bst_node_t *tree) {
+  bst_height_frame_t inline_frames[BST_ITER_STACK];
+  bst_height_frame_t *frames = inline_frames;
+  int capacity = BST_ITER_STACK;
+  int top = -1;
+  int height = 0;
+
+  if (tree != NULL) {
+    frames[++top] = (bst_height_frame_t){tree, 1};
+  }
+  while (top >= 0) {
+    bst_height_frame_t frame = frames[top--];
+    if (frame.depth > height) {
+      height = frame.depth;
+    }
+    // Both children may be pushed, make room for two frames.
+    if (top + 2 >= capacity) {
+      bst_height_frame_t *grown;
+      if (frames == inline_frames) {
+        grown = malloc(2 * capacity * sizeof(bst_height_frame_t));
+        if (grown != NULL) {
+          memcpy(grown, inline_frames, sizeof(inline_frames));
+        }
+      } else {
+        grown = realloc(frames, 2 * capacity * sizeof(bst_height_frame_t));
+      }
+      if (grown == NULL) {
+        height = -1;
+        break;
+      }
+      frames = grown;
+      capacity *= 2;
+    }
+    if (frame.node->right != NULL) {
+      frames[++top] = (bst_height_frame_t){frame.node->right, frame.depth + 1};
+    }
+    if (frame.node->left != NULL) {
+      frames[++top] = (bst_height_frame_t){frame.node->left, frame.depth + 1};
+    }
+  }
+
+  if (frames != inline_frames) {
+    free(frames);
+  }
+  return height;
+}
+
+/*
+ * Pomocná funkce která uloží uzly podstromu v pořadí inorder do items,
+ * nejvýše však items->capacity uzlů (bez realokace).
+ */
+void bst_to_array(bst_node_t *node, bst_items_t *items) {
+  // Base case
+  if (node == NULL)
+    return;
+
+  // Recursively convert the left subtree
+  bst_to_array(node->left, items);
+
+  // Add the current node to the array of items
+  if (items->size < items->capacity) {
+    items->nodes[items->size++] = node;
+  }
+
+  // Recursively convert the right subtree
+  bst_to_array(node->right, items);
+}
+
+/*
+ * Pomocná funkce která z uzlů nodes[start..end] seřazených podle klíče
+ * sestaví vyvážený podstrom a vrátí jeho kořen.
+ */
+bst_node_t* array_to_bst(int start, int end, bst_node_t **nodes) {
+  // Base case
+  if (start > end)
+    return NULL;
+
+  // Get the middle element and make it root
+  int mid = (start + end) / 2;
+  bst_node_t *root = nodes[mid];
+
+  // Recursively construct the left subtree
+  root->left = array_to_bst(start, mid - 1, nodes);
+
+  // Recursively construct the right subtree
+  root->right = array_to_bst(mid + 1, end, nodes);
+
+  BST_UPDATE_SIZE(root);
+  return root;
+}
+
+/*
+ * Pomocná funkce která přestaví podstrom o size uzlech na vyvážený.
+ *
+ * Uzly se nealokují znovu, jen se přepojí. V případě chyby alokace
+ * pomocného pole zůstane podstrom beze změny.
+ */
+void bst_rebuild(bst_node_t **tree, int size) {
+  bst_items_t items;
+  items.capacity = size;
+  items.size = 0;
+  items.nodes = malloc(size * sizeof(bst_node_t *));
+  if (items.nodes == NULL) {
+    return;
+  }
+
+  bst_to_array(*tree, &items);
+  *tree = array_to_bst(0, items.size - 1, items.nodes);
+  free(items.nodes);
+}
+
+_Thread_local bst_scapegoat_t *BST_SCAPEGOAT = NULL;
+
+/*
+ * Inicializace automatického vyvažování pro strom *tree.
+ *
+ * Stav se přiřadí do BST_SCAPEGOAT před voláním bst_insert a bst_delete
+ * nad tímto stromem, tedy se stejným ukazatelem tree. Pokud strom není
+ * prázdný, spočítají se jeho uzly.
+ */
+void bst_scapegoat_init(bst_scapegoat_t *scapegoat, bst_node_t **tree) {
+  scapegoat->tree = tree;
+  scapegoat->size = BST_SIZE(*tree);
+  scapegoat->max_size = scapegoat->size;
+  scapegoat->depth = 0;
+  scapegoat->subtree_size = 0;
+}
+
+/*
+ * Stav automatického vyvažování pro strom *tree.
+ *
+ * Vrátí BST_SCAPEGOAT, pokud sleduje strom *tree nebo pokud rekurzivní
+ * volání nad sledovaným stromem právě prochází jeho podstrom. Jinak vrátí
+ * NULL a strom se nevyvažuje.
+ */
+bst_scapegoat_t *bst_scapegoat_of(bst_node_t **tree) {
+  if (BST_SCAPEGOAT == NULL) {
+    return NULL;
+  }
+  if (BST_SCAPEGOAT->tree == tree || BST_SCAPEGOAT->depth > 0) {
+    return BST_SCAPEGOAT;
+  }
+  return NULL;
+}
+
+/*
+ * Pomocná funkce která zjistí, zda je uzel v hloubce depth příliš hluboko
+ * pro strom o size uzlech, tedy zda depth > log_{1/α}(size) pro α = 2/3.
+ */
+bool bst_scapegoat_too_deep(int depth, int size) {
+  double bound = 1;
+  for (int i = 0; i < depth && bound <= size; i++) {
+    bound *= 1.5;
+  }
+  return bound > size;
+}
+
+/*
+ * Pomocná funkce pro jeden krok hledání obětního beránka.
+ *
+ * Podstrom potomka uzlu *tree (levého, pokud from_left) má
+ * BST_SCAPEGOAT->subtree_size uzlů. Pokud tvoří více než 2/3 podstromu
+ * *tree, je *tree obětním beránkem a podstrom se přestaví. Jinak se
+ * do subtree_size uloží velikost podstromu *tree pro další krok nahoru.
+ */
+void bst_scapegoat_climb(bst_node_t **tree, bool from_left) {
+  int child_size = BST_SCAPEGOAT->subtree_size;
+  bst_node_t *sibling = from_left ? (*tree)->right : (*tree)->left;
+  int size = 1 + child_size + BST_SIZE(sibling);
+
+  if (child_size * 3 > size * 2) {
+    bst_rebuild(tree, size);
+    BST_SCAPEGOAT->subtree_size = 0;
+  } else {
+    BST_SCAPEGOAT->subtree_size = size;
+  }
+}
+
+/*
+ * Počet uzlů stromu.
+ *
+ * Při překladu s BST_ORDER_STATISTICS v čase O(1), jinak O(n).
+ */
+int bst_size(bst_node_t *tree) {
+  return BST_SIZE(tree);
+}
+
+_Thread_local bool BST_SPLAY = false;
+
+/*
+ * Pomocná funkce pro rotaci doprava, která ponechá na místě uzel tree.
+ *
+ * Uzel tree a jeho levý potomek si vymění klíč a hodnotu a přepojí své
+ * podstromy. Kořen stromu tak zůstává stejným uzlem a splay lze provést
+ * i v bst_search, která ukazatel na kořen nemůže změnit.
+ */
+static void bst_rotate_right_in_place(bst_node_t *tree) {
+  bst_node_t *left = tree->left;
+  char key = tree->key;
+  int value = tree->value;
+  tree->key = left->key;
+  tree->value = left->value;
+  left->key = key;
+  left->value = value;
+
+  tree->left = left->left;
+  left->left = left->right;
+  left->right = tree->right;
+  tree->right = left;
+  BST_UPDATE_SIZE(left);
+  BST_UPDATE_SIZE(tree);
+}
+
+/*
+ * Pomocná funkce pro rotaci doleva, zrcadlová k bst_rotate_right_in_place.
+ */
+static void bst_rotate_left_in_place(bst_node_t *tree) {
+  bst_node_t *right = tree->right;
+  char key = tree->key;
+  int value = tree->value;
+  tree->key = right->key;
+  tree->value = right->value;
+  right->key = key;
+  right->value = value;
+
+  tree->right = right->right;
+  right->right = right->left;
+  right->left = tree->left;
+  tree->left = right;
+  BST_UPDATE_SIZE(right);
+  BST_UPDATE_SIZE(tree);
+}
+
+/*
+ * Přesun uzlu s klíčem key do kořene podstromu tree (splay).
+ *
+ * Pokud klíč ve stromu není, přesune se do kořene poslední uzel na cestě
+ * k němu. Rotace po dvojicích (zig-zig, zig-zag) zkracují celou cestu
+ * zhruba na polovinu, amortizovaná cena operace je proto O(log n).
+ * Uzel tree zůstává kořenem, mění se jen klíče a hodnoty uzlů.
+ */
+void bst_splay(bst_node_t *tree, char key) {
+  if (tree == NULL || tree->key == key) {
+    return;
+  }
+
+  if (key < tree->key) {
+    bst_node_t *left = tree->left;
+    if (left == NULL) {
+      return;
+    }
+    if (key < left->key && left->left != NULL) { // zig-zig
+      bst_splay(left->left, key);
+      bst_rotate_right_in_place(tree);
+    } else if (key > left->key && left->right != NULL) { // zig-zag
+      bst_splay(left->right, key);
+      bst_rotate_left_in_place(left);
+    }
+    bst_rotate_right_in_place(tree);
+  } else {
+    bst_node_t *right = tree->right;
+    if (right == NULL) {
+      return;
+    }
+    if (key > right->key && right->right != NULL) { // zig-zig
+      bst_splay(right->right, key);
+      bst_rotate_left_in_place(tree);
+    } else if (key < right->key && right->left != NULL) { // zig-zag
+      bst_splay(right->left, key);
+      bst_rotate_right_in_place(right);
+    }
+    bst_rotate_left_in_place(tree);
+  }
+}
+
+/*
+ * Vložení uzlu v režimu BST_SPLAY.
+ *
+ * Po přesunu nejbližšího klíče do kořene se strom rozdělí na klíče menší
+ * a větší než key a nový uzel se stane kořenem.
+ */
+void bst_splay_insert(bst_node_t **tree, char key, int value) {
+  if ((*tree) != NULL) {
+    bst_splay(*tree, key);
+    if ((*tree)->key == key) {
+      (*tree)->value = value;
+      return;
+    }
+  }
+
+  bst_node_t *node = bst_node_alloc();
+  if (node == NULL) {
+    return;
+  }
+  node->key = key;
+  node->value = value;
+  node->left = NULL;
+  node->right = NULL;
+  if ((*tree) != NULL && key < (*tree)->key) {
+    node->left = (*tree)->left;
+    node->right = (*tree);
+    (*tree)->left = NULL;
+    BST_UPDATE_SIZE(*tree);
+  } else if ((*tree) != NULL) {
+    node->right = (*tree)->right;
+    node->left = (*tree);
+    (*tree)->right = NULL;
+    BST_UPDATE_SIZE(*tree);
+  }
+  BST_UPDATE_SIZE(node);
+  (*tree) = node;
+}
+
+/*
+ * Odstranění uzlu v režimu BST_SPLAY.
+ *
+ * Odstraňovaný uzel se přesune do kořene a nahradí ho největší uzel
+ * levého podstromu, který se nejdříve přesune do kořene levého podstromu
+ * (a nemá tedy pravého potomka).
+ */
+void bst_splay_delete(bst_node_t **tree, char key) {
+  if ((*tree) == NULL) {
+    return;
+  }
+  bst_splay(*tree, key);
+  if ((*tree)->key != key) {
+    return;
+  }
+
+  bst_node_t *node = (*tree);
+  if (node->left == NULL) {
+    (*tree) = node->right;
+  } else {
+    // Every key of the left subtree is smaller, so its maximum comes up.
+    bst_splay(node->left, key);
+    node->left->right = node->right;
+    BST_UPDATE_SIZE(node->left);
+    (*tree) = node->left;
+  }
+  bst_node_free(node);
+}
+
+/*
+ * Rozdělení stromu podle klíče key.
+ *
+ * Uzly s menším klíčem přesune do stromu *less, uzly s větším klíčem do
+ * stromu *greater a uzel s klíčem key (bez potomků) vrátí, nebo vrátí
+ * NULL, pokud ve stromu není. Funkce nealokuje ani neuvolňuje uzly
+ * a projde jen cestu ke klíči, cena je tedy O(výška). Výška obou částí
+ * není větší než výška původního stromu.
+ */
+bst_node_t *bst_split(bst_node_t *tree, char key, bst_node_t **less,
+                      bst_node_t **greater) {
+  if (tree == NULL) {
+    (*less) = NULL;
+    (*greater) = NULL;
+    return NULL;
+  }
+
+  bst_node_t *found;
+  if (key < tree->key) {
+    // The node and its right subtree are greater, split the left subtree.
+    found = bst_split(tree->left, key, less, &tree->left);
+    (*greater) = tree;
+  } else if (key > tree->key) {
+    found = bst_split(tree->right, key, &tree->right, greater);
+    (*less) = tree;
+  } else {
+    (*less) = tree->left;
+    (*greater) = tree->right;
+    tree->left = NULL;
+    tree->right = NULL;
+    found = tree;
+  }
+  BST_UPDATE_SIZE(tree);
+  return found;
+}
+
+/*
+ * Spojení dvou stromů, kde všechny klíče stromu less jsou menší než
+ * klíče stromu greater.
+ *
+ * Největší uzel stromu less se stane kořenem s podstromy less a greater,
+ * výška výsledku je tedy nejvýše o jedna větší než výška vyššího stromu.
+ * Cena je O(výška less).
+ */
+bst_node_t *bst_join(bst_node_t *less, bst_node_t *greater) {
+  if (less == NULL) {
+    return greater;
+  }
+  if (greater == NULL) {
+    return less;
+  }
+
+  // Detach the rightmost node of less, its ancestors lose one node.
+  bst_node_t **rightmost = &less;
+  while ((*rightmost)->right != NULL) {
+    BST_ADD_SIZE(*rightmost, -1);
+    rightmost = &((*rightmost)->right);
+  }
+  bst_node_t *root = (*rightmost);
+  (*rightmost) = root->left;
+
+  root->left = less;
+  root->right = greater;
+  BST_UPDATE_SIZE(root);
+  return root;
+}
+
+/*
+ * Pomocná funkce pro bst_union, která sjednotí stromy bez vyvažování.
+ *
+ * Strom a se rozdělí podle kořene b a obě poloviny se rekurzivně sjednotí
+ * s podstromy b. Každý uzel b tak projde cestu ve zbytku a, cena je
+ * O(m * výška a) pro m = |b| a výška výsledku je nejvýše součtem výšek.
+ */
+static bst_node_t *bst_union_split(bst_node_t *a, bst_node_t *b,
+                                   int (*combine)(int, int)) {
+  if (a == NULL) {
+    return b;
+  }
+  if (b == NULL) {
+    return a;
+  }
+
+  bst_node_t *less;
+  bst_node_t *greater;
+  bst_node_t *duplicate = bst_split(a, b->key, &less, &greater);
+  if (duplicate != NULL) {
+    if (combine != NULL) {
+      b->value = combine(duplicate->value, b->value);
+    }
+    bst_node_free(duplicate);
+  }
+
+  b->left = bst_union_split(less, b->left, combine);
+  b->right = bst_union_split(greater, b->right, combine);
+  BST_UPDATE_SIZE(b);
+  return b;
+}
+
+/*
+ * Sjednocení stromů a a b.
+ *
+ * Výsledný strom obsahuje uzly obou stromů, původní stromy tedy zanikají.
+ * Pro klíč obsažený v obou stromech zůstane jediný uzel s hodnotou
+ * combine(hodnota v a, hodnota v b), např. součtem četností, nebo
+ * s hodnotou z b, pokud je combine NULL. Druhý uzel se uvolní.
+ *
+ * Uzly nemají údaj o vyvážení, sjednocení rozdělením (bst_union_split)
+ * proto samo výšku neudrží a výsledek se na závěr přestaví na vyvážený
+ * (bst_rebuild). Celková cena je O(m * výška a + n + m) pro n = |a|
+ * a m = |b|, menší strom proto předávejte jako b. Pokud se nepodaří
+ * alokovat pomocné pole, zůstane výsledek platný, jen nevyvážený.
+ */
+bst_node_t *bst_union(bst_node_t *a, bst_node_t *b, int (*combine)(int, int)) {
+  bst_node_t *tree = bst_union_split(a, b, combine);
+  if (tree != NULL) {
+    bst_rebuild(&tree, bst_size(tree));
+  }
+  return tree;
+}
+
+/*
+ * Pomocná funkce která určí, zda uzel a patří v pořadí bst_top_k před
+ * uzel b (vyšší hodnota, při shodě menší klíč).
+ */
+static bool bst_top_before(bst_node_t *a, bst_node_t *b) {
+  return a->value > b->value || (a->value == b->value && a->key < b->key);
+}
+
+/*
+ * Pomocná funkce která posune uzel haldy na indexu i směrem ke kořeni.
+ * V kořeni haldy je uzel, který v pořadí bst_top_k patří na konec.
+ */
+static void bst_top_sift_up(bst_node_t *heap[], int i) {
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!bst_top_before(heap[parent], heap[i])) {
+      return;
+    }
+    bst_node_t *swap = heap[parent];
+    heap[parent] = heap[i];
+    heap[i] = swap;
+    i = parent;
+  }
+}
+
+/*
+ * Pomocná funkce která posune uzel haldy velikosti size na indexu i
+ * směrem k listům.
+ */
+static void bst_top_sift_down(bst_node_t *heap[], int size, int i) {
+  while (2 * i + 1 < size) {
+    int child = 2 * i + 1;
+    if (child + 1 < size && bst_top_before(heap[child], heap[child + 1])) {
+      child++;
+    }
+    if (!bst_top_before(heap[i], heap[child])) {
+      return;
+    }
+    bst_node_t *swap = heap[child];
+    heap[child] = heap[i];
+    heap[i] = swap;
+    i = child;
+  }
+}
+
+/*
+ * Nalezení k uzlů s nejvyššími hodnotami, např. nejčastějších znaků po
+ * letter_count.
+ *
+ * Uzly se zapíšou do pole top (o velikosti alespoň k) sestupně podle
+ * hodnoty, uzly se stejnou hodnotou vzestupně podle klíče. Funkce vrátí
+ * počet zapsaných uzlů, nejvýše k. Strom se projde jednou iterátorem
+ * a uzly procházejí haldou v poli top, v jejímž kořeni je nejhorší
+ * z dosud vybraných uzlů. Čas je O(n log k), pomocná paměť je jen
+ * zásobník iterátoru. Pokud se zásobník nepodaří alokovat, vrátí -1.
+ */
+int bst_top_k(bst_node_t *tree, int k, bst_node_t *top[]) {
+  if (k <= 0) {
+    return 0;
+  }
+
+  int size = 0;
+  bst_iter_t iter;
+  bst_iter_begin_preorder(&iter, tree);
+  bst_node_t *node;
+  while ((node = bst_iter_next(&iter)) != NULL) {
+    if (size < k) {
+      top[size] = node;
+      bst_top_sift_up(top, size);
+      size++;
+    } else if (bst_top_before(node, top[0])) {
+      top[0] = node;
+      bst_top_sift_down(top, size, 0);
+    }
+  }
+  bst_iter_end(&iter);
+  if (iter.failed) {
+    return -1;
+  }
+
+  // Heap sort, the worst node goes to the end.
+  for (int last = size - 1; last > 0; last--) {
+    bst_node_t *swap = top[0];
+    top[0] = top[last];
+    top[last] = swap;
+    bst_top_sift_down(top, last, 0);
+  }
+  return size;
+}
+
+// Počáteční hloubka zásobníku bst_dump (bez alokace)
+#define BST_DUMP_STACK 32
+
+// Délka odsazení jedné úrovně textového výpisu
+#define BST_DUMP_INDENT 3
+
+// Kterým potomkem svého rodiče je vypisovaný uzel
+typedef enum bst_dump_side {
+  BST_DUMP_ROOT,
+  BST_DUMP_LEFT,
+  BST_DUMP_RIGHT
+} bst_dump_side_t;
+
+// Uzel na zásobníku bst_dump
+typedef struct bst_dump_frame {
+  bst_node_t *node;       // vypisovaný uzel
+  bst_dump_side_t side;   // kterým potomkem rodiče uzel je
+  int phase;              // 0 před prvním potomkem, 1 před druhým, 2 po nich
+} bst_dump_frame_t;
+
+// Stav výpisu stromu
+typedef struct bst_dump_state {
+  FILE *out;                   // výstup
+  bst_dump_frame_t *frames;    // zásobník uzlů od kořene
+  char *prefix;                // odsazení, úroveň i na prefix[i * 3]
+  int capacity;                // kapacita zásobníku (počet úrovní)
+  int top;                     // index vrcholu zásobníku
+  bst_dump_frame_t inline_frames[BST_DUMP_STACK];
+  char inline_prefix[BST_DUMP_STACK * BST_DUMP_INDENT];
+} bst_dump_state_t;
+
+/*
+ * Pomocná funkce která vloží uzel na zásobník výpisu.
+ *
+ * Zásobník i odsazení začínají v polích uvnitř stavu a na haldu se
+ * přesunou, až když výška stromu přesáhne BST_DUMP_STACK. Při chybě
+ * alokace vrátí false.
+ */
+static bool bst_dump_push(bst_dump_state_t *dump, bst_node_t *node,
+                          bst_dump_side_t side) {
+  if (dump->top == dump->capacity - 1) {
+    int capacity = dump->capacity * 2;
+    bst_dump_frame_t *frames;
+    char *prefix;
+    if (dump->frames == dump->inline_frames) {
+      frames = malloc(capacity * sizeof(bst_dump_frame_t));
+      prefix = malloc((size_t)capacity * BST_DUMP_INDENT);
+      if (frames == NULL || prefix == NULL) {
+        free(frames);
+        free(prefix);
+        return false;
+      }
+      memcpy(frames, dump->inline_frames, sizeof(dump->inline_frames));
+      memcpy(prefix, dump->inline_prefix, sizeof(dump->inline_prefix));
+    } else {
+      frames = realloc(dump->frames, capacity * sizeof(bst_dump_frame_t));
+      if (frames == NULL) {
+        return false;
+      }
+      dump->frames = frames;
+      prefix = realloc(dump->prefix, (size_t)capacity * BST_DUMP_INDENT);
+      if (prefix == NULL) {
+        return false;
+      }
+    }
+    dump->frames = frames;
+    dump->prefix = prefix;
+    dump->capacity = capacity;
+  }
+  dump->top++;
+  dump->frames[dump->top].node = node;
+  dump->frames[dump->top].side = side;
+  dump->frames[dump->top].phase = 0;
+  return true;
+}
+
+/*
+ * Pomocná funkce která vypíše klíč, uvozovky a zpětná lomítka s escape
+ * sekvencí. Netisknutelné klíče se vypíšou jako \uXXXX v JSON a jako
+ * \\xXX (text \xXX) v DOT.
+ */
+static void bst_dump_key(FILE *out, char key, bool json) {
+  unsigned char code = (unsigned char)key;
+  if (code == '"' || code == '\\') {
+    fprintf(out, "\\%c", key);
+  } else if (code < 0x20 || code >= 0x7f) {
+    fprintf(out, json ? "\\u%04x" : "\\\\x%02x", code);
+  } else {
+    fputc(key, out);
+  }
+}
+
+/*
+ * Pomocná funkce pro textový výpis, stejný jako z bst_print_tree.
+ *
+ * Uzel na hloubce depth má odsazení prefix[0 .. depth * 3 - 1], za ním si
+ * do prefixu zapíše odsazení svých potomků. Pravý podstrom se vypíše nad
+ * uzlem, levý pod ním. Vrátí potomka, do kterého se má sestoupit.
+ */
+static bst_node_t *bst_dump_text(bst_dump_state_t *dump,
+                                 bst_dump_frame_t *frame, int depth,
+                                 bst_dump_side_t *side) {
+  size_t indent = (size_t)depth * BST_DUMP_INDENT;
+  char *children = dump->prefix + indent;
+  switch (frame->phase) {
+  case 0:
+    if (frame->side == BST_DUMP_LEFT) {
+      fwrite(dump->prefix, 1, indent, dump->out);
+      fputs("  |\n", dump->out);
+    }
+    memcpy(children, frame->side == BST_DUMP_LEFT ? "  |" : "   ",
+           BST_DUMP_INDENT);
+    *side = BST_DUMP_RIGHT;
+    return frame->node->right;
+  case 1:
+    fwrite(dump->prefix, 1, indent, dump->out);
+    fprintf(dump->out, "  +-[%c,%d]\n", frame->node->key,
+            frame->node->value);
+    memcpy(children, frame->side == BST_DUMP_RIGHT ? "  |" : "   ",
+           BST_DUMP_INDENT);
+    *side = BST_DUMP_LEFT;
+    return frame->node->left;
+  default:
+    if (frame->side == BST_DUMP_RIGHT) {
+      fwrite(dump->prefix, 1, indent, dump->out);
+      fputs("  |\n", dump->out);
+    }
+    return NULL;
+  }
+}
+
+/*
+ * Pomocná funkce pro výpis do DOT, uzly jsou pojmenované podle klíče.
+ */
+static bst_node_t *bst_dump_dot(bst_dump_state_t *dump,
+                                bst_dump_frame_t *frame,
+                                bst_dump_side_t *side) {
+  bst_node_t *node = frame->node;
+  unsigned char key = (unsigned char)node->key;
+  switch (frame->phase) {
+  case 0:
+    fprintf(dump->out, "  n%u [label=\"[", key);
+    bst_dump_key(dump->out, node->key, false);
+    fprintf(dump->out, ",%d]\"];\n", node->value);
+    if (node->left != NULL) {
+      fprintf(dump->out, "  n%u -> n%u [tailport=sw];\n", key,
+              (unsigned char)node->left->key);
+    }
+    if (node->right != NULL) {
+      fprintf(dump->out, "  n%u -> n%u [tailport=se];\n", key,
+              (unsigned char)node->right->key);
+    }
+    *side = BST_DUMP_LEFT;
+    return node->left;
+  case 1:
+    *side = BST_DUMP_RIGHT;
+    return node->right;
+  default:
+    return NULL;
+  }
+}
+
+/*
+ * Pomocná funkce pro výpis do JSON, chybějící potomek je null.
+ */
+static bst_node_t *bst_dump_json(bst_dump_state_t *dump,
+                                 bst_dump_frame_t *frame,
+                                 bst_dump_side_t *side) {
+  bst_node_t *node = frame->node;
+  switch (frame->phase) {
+  case 0:
+    fputs("{\"key\":\"", dump->out);
+    bst_dump_key(dump->out, node->key, true);
+    fprintf(dump->out, "\",\"value\":%d,\"left\":", node->value);
+    if (node->left == NULL) {
+      fputs("null", dump->out);
+    }
+    *side = BST_DUMP_LEFT;
+    return node->left;
+  case 1:
+    fputs(",\"right\":", dump->out);
+    if (node->right == NULL) {
+      fputs("null", dump->out);
+    }
+    *side = BST_DUMP_RIGHT;
+    return node->right;
+  default:
+    fputc('}', dump->out);
+    return NULL;
+  }
+}
+
+/*
+ * Výpis stromu do proudu out ve formátu format (viz bst_dump_format_t).
+ *
+ * Strom se prochází iterativně se zásobníkem o velikosti výšky stromu
+ * a textový výpis skládá odsazení řádků v jednom bufferu, takže funkce
+ * nealokuje pro jednotlivé uzly, nepřeteče zásobník ani u degenerovaného
+ * stromu a výstup zapisuje průběžně. DOT a JSON mají délku O(n), textový
+ * výpis obsahuje na každém řádku odsazení své hloubky. Funkce vrátí
+ * false, pokud se nepodařilo alokovat zásobník (výstup je pak neúplný)
+ * nebo zapisovat do proudu.
+ */
+bool bst_dump(bst_node_t *tree, FILE *out, bst_dump_format_t format) {
+  bst_dump_state_t dump;
+  dump.out = out;
+  dump.frames = dump.inline_frames;
+  dump.prefix = dump.inline_prefix;
+  dump.capacity = BST_DUMP_STACK;
+  dump.top = -1;
+
+  if (format == BST_DUMP_DOT) {
+    fputs("digraph bst {\n", out);
+  } else if (format == BST_DUMP_JSON && tree == NULL) {
+    fputs("null", out);
+  }
+
+  bool ok = tree == NULL || bst_dump_push(&dump, tree, BST_DUMP_ROOT);
+  while (ok && dump.top >= 0) {
+    bst_dump_frame_t *frame = &dump.frames[dump.top];
+    bst_dump_side_t side = BST_DUMP_ROOT;
+    bst_node_t *child;
+    switch (format) {
+    case BST_DUMP_TEXT:
+      child = bst_dump_text(&dump, frame, dump.top, &side);
+      break;
+    case BST_DUMP_DOT:
+      child = bst_dump_dot(&dump, frame, &side);
+      break;
+    default:
+      child = bst_dump_json(&dump, frame, &side);
+      break;
+    }
+    if (frame->phase++ == 2) {
+      dump.top--;
+    } else if (child != NULL) {
+      ok = bst_dump_push(&dump, child, side);
+    }
+  }
+
+  if (format == BST_DUMP_DOT) {
+    fputs("}\n", out);
+  } else if (format == BST_DUMP_JSON) {
+    fputc('\n', out);
+  }
+  if (dump.frames != dump.inline_frames) {
+    free(dump.frames);
+    free(dump.prefix);
+  }
+  return ok && !ferror(out);
+}
+
+#ifdef BST_STATS
+
+_Thread_local stats_t bst_stats;
+
+/*
+ * Vynulování počítadel bst_stats aktuálního vlákna.
+ */
+void bst_stats_reset(void) {
+  stats_t empty = {0};
+  bst_stats = empty;
+}
+
+/*
+ * Výpis souhrnu počítadel stats (např. bst_stats aktuálního vlákna nebo
+ * součtu více vláken, viz stats_merge) a výšky stromu tree.
+ *
+ * Pro každou operaci vypíše počet volání, průměrný počet porovnání klíčů
+ * a navštívených uzlů (délku cesty) na volání, nejdelší cestu, alokace
+ * a uvolnění uzlů a percentily p50, p99 a p999 doby trvání.
+ */
+void bst_stats_report(FILE *out, const stats_t *stats, bst_node_t *tree) {
+  fprintf(out, "Tree height %d\n", bst_height(tree));
+  stats_print_op(out, "search", &stats->ops[BST_STATS_SEARCH]);
+  stats_print_op(out, "insert", &stats->ops[BST_STATS_INSERT]);
+  stats_print_op(out, "delete", &stats->ops[BST_STATS_DELETE]);
+}
+
+#endif // BST_STATS
+
+#ifdef BST_PERSISTENT
+
+/*
+ * Pomocná funkce která vytvoří uzel perzistentního stromu.
+ *
+ * Nový uzel převezme odkazy na podstromy left a right, volající je tedy
+ * musí předem získat (bst_persistent_retain nebo nová verze podstromu).
+ */
+static bst_node_t *bst_persistent_node(char key, int value, bst_node_t *left,
+                                       bst_node_t *right) {
+  bst_node_t *node = bst_node_alloc();
+  if (node == NULL) {
+    bst_persistent_release(left);
+    bst_persistent_release(right);
+    return NULL;
+  }
+  node->key = key;
+  node->value = value;
+  node->left = left;
+  node->right = right;
+  BST_UPDATE_SIZE(node);
+  return node;
+}
+
+/*
+ * Získání odkazu na verzi stromu (nebo podstrom), která pak nezanikne,
+ * dokud ji volající neuvolní funkcí bst_persistent_release.
+ */
+bst_node_t *bst_persistent_retain(bst_node_t *tree) {
+  if (tree != NULL) {
+    atomic_fetch_add_explicit(&tree->refs, 1, memory_order_relaxed);
+  }
+  return tree;
+}
+
+/*
+ * Uvolnění odkazu na verzi stromu.
+ *
+ * Uzly, na které už neodkazuje žádná verze ani jiný uzel, se uvolní.
+ * Uzly sdílené s jinou verzí zůstávají. Pool BST_POOL není vláknově
+ * bezpečný a patří jen vláknu, které ho nastavilo. S ním proto smí verze
+ * uvolňovat jen toto vlákno.
+ */
+void bst_persistent_release(bst_node_t *tree) {
+  while (tree != NULL &&
+         atomic_fetch_sub_explicit(&tree->refs, 1, memory_order_acq_rel) == 1) {
+    bst_node_t *right = tree->right;
+    bst_persistent_release(tree->left);
+    bst_node_free(tree);
+    // The right subtree is released in the loop, not recursively.
+    tree = right;
+  }
+}
+
+/*
+ * Pomocná funkce pro bst_persistent_insert, vrátí kořen nové verze
+ * podstromu tree, nebo NULL při chybě alokace. Při chybě se uvolní vše,
+ * co funkce na kterékoliv úrovni stihla vytvořit nebo získat.
+ */
+static bst_node_t *bst_persistent_insert_path(bst_node_t *tree, char key,
+                                              int value) {
+  if (tree == NULL) {
+    return bst_persistent_node(key, value, NULL, NULL);
+  }
+  if (key < tree->key) {
+    bst_node_t *left = bst_persistent_insert_path(tree->left, key, value);
+    if (left == NULL) {
+      return NULL;
+    }
+    return bst_persistent_node(tree->key, tree->value, left,
+                               bst_persistent_retain(tree->right));
+  } else if (key > tree->key) {
+    bst_node_t *right = bst_persistent_insert_path(tree->right, key, value);
+    if (right == NULL) {
+      return NULL;
+    }
+    return bst_persistent_node(tree->key, tree->value,
+                               bst_persistent_retain(tree->left), right);
+  }
+  return bst_persistent_node(key, value, bst_persistent_retain(tree->left),
+                             bst_persistent_retain(tree->right));
+}
+
+/*
+ * Vložení uzlu do perzistentního stromu.
+ *
+ * Do *version uloží kořen nové verze, do které se zkopírují jen uzly na
+ * cestě od kořene k vloženému (nebo změněnému) uzlu, tedy O(výška) uzlů.
+ * Verze tree zůstává beze změny a volající dál vlastní odkaz na ni.
+ *
+ * Při chybě alokace vrátí false a nic nealokuje. Sdílené uzly se nesmí
+ * měnit, v režimech BST_SPLAY a BST_SCAPEGOAT proto funkce také vrátí
+ * false.
+ */
+bool bst_persistent_insert(bst_node_t *tree, char key, int value,
+                           bst_node_t **version) {
+  if (BST_SPLAY || BST_SCAPEGOAT != NULL) {
+    return false;
+  }
+  bst_node_t *result = bst_persistent_insert_path(tree, key, value);
+  if (result == NULL) {
+    return false;
+  }
+  *version = result;
+  return true;
+}
+
+/*
+ * Pomocná funkce pro bst_persistent_delete, klíč ve stromu je.
+ *
+ * Do *version uloží kořen nové verze podstromu tree (i prázdné). Při chybě
+ * alokace vrátí false a uvolní vše, co stihla vytvořit nebo získat.
+ */
+static bool bst_persistent_remove(bst_node_t *tree, char key,
+                                  bst_node_t **version) {
+  if (key < tree->key) {
+    bst_node_t *left;
+    if (!bst_persistent_remove(tree->left, key, &left)) {
+      return false;
+    }
+    *version = bst_persistent_node(tree->key, tree->value, left,
+                                   bst_persistent_retain(tree->right));
+    return *version != NULL;
+  } else if (key > tree->key) {
+    bst_node_t *right;
+    if (!bst_persistent_remove(tree->right, key, &right)) {
+      return false;
+    }
+    *version = bst_persistent_node(tree->key, tree->value,
+                                   bst_persistent_retain(tree->left), right);
+    return *version != NULL;
+  }
+
+  if (tree->left == NULL) {
+    *version = bst_persistent_retain(tree->right);
+    return true;
+  } else if (tree->right == NULL) {
+    *version = bst_persistent_retain(tree->left);
+    return true;
+  }
+  // Replace by the rightmost node of the left subtree, as bst_delete does.
+  bst_node_t *rightmost = tree->left;
+  while (rightmost->right != NULL) {
+    rightmost = rightmost->right;
+  }
+  bst_node_t *left;
+  if (!bst_persistent_remove(tree->left, rightmost->key, &left)) {
+    return false;
+  }
+  *version = bst_persistent_node(rightmost->key, rightmost->value, left,
+                                 bst_persistent_retain(tree->right));
+  return *version != NULL;
+}
+
+/*
+ * Odstranění uzlu z perzistentního stromu.
+ *
+ * Do *version uloží kořen nové verze (po odstranění posledního uzlu NULL),
+ * verze tree zůstává beze změny. Pokud klíč ve stromu není, nová verze
+ * sdílí celý strom tree. Chyby jako u bst_persistent_insert.
+ */
+bool bst_persistent_delete(bst_node_t *tree, char key, bst_node_t **version) {
+  if (BST_SPLAY || BST_SCAPEGOAT != NULL) {
+    return false;
+  }
+  // A plain descent, bst_search could splay nodes shared with readers.
+  bst_node_t *node = tree;
+  while (node != NULL && node->key != key) {
+    node = key < node->key ? node->left : node->right;
+  }
+  if (node == NULL) {
+    *version = bst_persistent_retain(tree);
+    return true;
+  }
+  return bst_persistent_remove(tree, key, version);
+}
+
+/*
+ * Inicializace sdílené aktuální verze (prázdný strom).
+ */
+void bst_versions_init(bst_versions_t *versions) {
+  versions->root = NULL;
+  atomic_flag_clear(&versions->lock);
+}
+
+/*
+ * Získání aktuální verze pro čtení.
+ *
+ * Zámek chrání jen přečtení kořene a zvýšení jeho počtu odkazů, aby verzi
+ * mezitím neuvolnilo zapisující vlákno. Samotné čtení verze pak zámek
+ * nepotřebuje. Verzi je nutné uvolnit funkcí bst_persistent_release.
+ */
+bst_node_t *bst_versions_snapshot(bst_versions_t *versions) {
+  while (atomic_flag_test_and_set_explicit(&versions->lock,
+                                           memory_order_acquire)) {
+  }
+  bst_node_t *tree = bst_persistent_retain(versions->root);
+  atomic_flag_clear_explicit(&versions->lock, memory_order_release);
+  return tree;
+}
+
+/*
+ * Zveřejnění nové verze tree, funkce převezme odkaz volajícího.
+ *
+ * Předchozí verze se uvolní, jakmile ji přestanou používat i všechna
+ * čtoucí vlákna.
+ */
+void bst_versions_publish(bst_versions_t *versions, bst_node_t *tree) {
+  while (atomic_flag_test_and_set_explicit(&versions->lock,
+                                           memory_order_acquire)) {
+  }
+  bst_node_t *old = versions->root;
+  versions->root = tree;
+  atomic_flag_clear_explicit(&versions->lock, memory_order_release);
+  bst_persistent_release(old);
+}
+
+/*
+ * Vložení uzlu do aktuální verze, smí volat jen zapisující vlákno.
+ *
+ * Nová verze se zveřejní jen v případě úspěchu. Při chybě (viz
+ * bst_persistent_insert) vrátí false a aktuální verze zůstane platná.
+ */
+bool bst_versions_insert(bst_versions_t *versions, char key, int value) {
+  // Only the writer replaces the root, so it may read it without the lock.
+  bst_node_t *version;
+  if (!bst_persistent_insert(versions->root, key, value, &version)) {
+    return false;
+  }
+  bst_versions_publish(versions, version);
+  return true;
+}
+
+/*
+ * Odstranění uzlu z aktuální verze, viz bst_versions_insert.
+ */
+bool bst_versions_delete(bst_versions_t *versions, char key) {
+  bst_node_t *version;
+  if (!bst_persistent_delete(versions->root, key, &version)) {
+    return false;
+  }
+  bst_versions_publish(versions, version);
+  return true;
+}
+
+/*
+ * Uvolnění aktuální verze.
+ */
+void bst_versions_dispose(bst_versions_t *versions) {
+  bst_versions_publish(versions, NULL);
+}
+
+#endif // BST_PERSISTENT
@@ -7,15 +7,180 @@
 #define IAL_BTREE_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#ifdef BST_PERSISTENT
+#include <stdatomic.h>
+#endif
+#ifdef BST_STATS
+#include "../stats/stats.h"
+#endif
 
 // Uzel stromu
 typedef struct bst_node {
   char key;               // klíč
   int value;              // hodnota
+#ifdef BST_ORDER_STATISTICS
+  int size;               // počet uzlů podstromu
+#endif
+#ifdef BST_PERSISTENT
+  atomic_int refs;        // počet verzí a rodičů sdílejících uzel
+#endif
   struct bst_node *left;  // levý potomek
   struct bst_node *right; // pravý potomek
 } bst_node_t;
 
+/*
+ * Počet uzlů podstromu a jeho přepočítání po změně potomků uzlu. Při
+ * překladu s BST_ORDER_STATISTICS si uzly svou velikost pamatují a makra
+ * mají cenu O(1), jinak se uzly podstromu spočítají.
+ */
+#ifdef BST_ORDER_STATISTICS
+#define BST_SIZE(NODE) ((NODE) != NULL ? (NODE)->size : 0)
+#define BST_UPDATE_SIZE(NODE)                                                  \
+  ((NODE)->size = 1 + BST_SIZE((NODE)->left) + BST_SIZE((NODE)->right))
+#define BST_ADD_SIZE(NODE, DELTA) ((NODE)->size += (DELTA))
+#else
+#define BST_SIZE(NODE) bst_count_nodes(NODE)
+#define BST_UPDATE_SIZE(NODE) ((void)0)
+#define BST_ADD_SIZE(NODE, DELTA) ((void)0)
+#endif
+
+/*
+ * Měření operací bst_search, bst_insert a bst_delete (viz stats.h). Při
+ * překladu s BST_STATS má každé vlákno počítadla bst_stats, jinak se
+ * makra přeloží na nic. BST_STATS_CMP(EXPR) započítá porovnání klíčů
+ * a vrátí hodnotu EXPR, BST_STATS_HOP() návštěvu uzlu.
+ */
+#ifdef BST_STATS
+// Index operace v bst_stats.ops
+typedef enum bst_stats_op {
+  BST_STATS_SEARCH,
+  BST_STATS_INSERT,
+  BST_STATS_DELETE
+} bst_stats_op_t;
+
+extern _Thread_local stats_t bst_stats;
+
+#define BST_STATS_ENTER(OP) stats_enter(&bst_stats, (OP))
+#define BST_STATS_LEAVE() stats_leave(&bst_stats)
+#define BST_STATS_CMP(EXPR) stats_compare(&bst_stats, (EXPR))
+#define BST_STATS_HOP() stats_hop(&bst_stats)
+#define BST_STATS_MEMORY(ALLOCATED) stats_memory(&bst_stats, (ALLOCATED))
+#else
+#define BST_STATS_ENTER(OP) ((void)0)
+#define BST_STATS_LEAVE() ((void)0)
+#define BST_STATS_CMP(EXPR) (EXPR)
+#define BST_STATS_HOP() ((void)0)
+#define BST_STATS_MEMORY(ALLOCATED) ((void)0)
+#endif
+
+// Počet uzlů v prvním bloku poolu, každý další blok je dvakrát větší
+#define BST_POOL_SLAB 64
+// Maximální počet uzlů v jednom bloku poolu
+#define BST_POOL_SLAB_MAX 65536
+
+// Blok souvislé paměti pro uzly
+typedef struct bst_pool_slab {
+  struct bst_pool_slab *next;  // další alokovaný blok
+  max_align_t nodes[];         // uzly bloku
+} bst_pool_slab_t;
+
+// Pool uzlů
+typedef struct bst_pool {
+  size_t node_size;            // velikost uzlu v bajtech
+  int slab_nodes;              // počet uzlů v příštím bloku
+  bst_pool_slab_t *slabs;      // seznam alokovaných bloků
+  void *free_nodes;            // seznam uvolněných uzlů k opětovnému použití
+  char *next;                  // první nepoužitý uzel posledního bloku
+  char *end;                   // konec posledního bloku
+} bst_pool_t;
+
+/*
+ * Pool, ze kterého bst_insert alokuje uzly. Pokud je NULL, uzly se alokují
+ * funkcí malloc. Každé vlákno má vlastní nastavení, uzly z poolu proto
+ * musí uvolnit vlákno, které pool nastavilo.
+ */
+extern _Thread_local bst_pool_t *BST_POOL;
+
+void bst_pool_init(bst_pool_t *pool, size_t node_size);
+void *bst_pool_alloc(bst_pool_t *pool);
+void bst_pool_free(bst_pool_t *pool, void *node);
+void bst_pool_dispose(bst_pool_t *pool);
+bst_node_t *bst_node_alloc(void);
+void bst_node_free(bst_node_t *node);
+
+// Stav automatického vyvažování (scapegoat strom, α = 2/3)
+typedef struct bst_scapegoat {
+  bst_node_t **tree;      // ukazatel na kořen sledovaného stromu
+  int size;               // počet uzlů stromu
+  int max_size;           // největší počet uzlů od přestavění celého stromu
+  int depth;              // hloubka rozpracovaného rekurzivního volání
+  int subtree_size;       // velikost podstromu při hledání obětního beránka
+} bst_scapegoat_t;
+
+/*
+ * Stav automatického vyvažování stromu, nad kterým se volá bst_insert
+ * a bst_delete. Pokud je NULL, strom se automaticky nevyvažuje. Stav patří
+ * jen stromu předanému do bst_scapegoat_init, ostatní stromy se jím
+ * nevyvažují a jejich rušení ho nemění. Každé vlákno má vlastní nastavení.
+ */
+extern _Thread_local bst_scapegoat_t *BST_SCAPEGOAT;
+
+void bst_scapegoat_init(bst_scapegoat_t *scapegoat, bst_node_t **tree);
+bst_scapegoat_t *bst_scapegoat_of(bst_node_t **tree);
+bool bst_scapegoat_too_deep(int depth, int size);
+void bst_scapegoat_climb(bst_node_t **tree, bool from_left);
+
+/*
+ * Samoupravující režim (splay strom). Pokud je nastaven, bst_search,
+ * bst_insert a bst_delete přesunou hledaný uzel rotacemi do kořene, takže
+ * často hledané klíče zůstávají blízko kořene. Má přednost před
+ * BST_SCAPEGOAT. Každé vlákno má vlastní nastavení. Protože i bst_search
+ * strom mění, nesmí ho v tomto režimu prohledávat více vláken současně.
+ */
+extern _Thread_local bool BST_SPLAY;
+
+void bst_splay(bst_node_t *tree, char key);
+void bst_splay_insert(bst_node_t **tree, char key, int value);
+void bst_splay_delete(bst_node_t **tree, char key);
+
+#ifdef BST_PERSISTENT
+/*
+ * Perzistentní verze stromu (při překladu s BST_PERSISTENT). Vložení
+ * a odstranění nemění původní strom, ale uloží do *version kořen nové
+ * verze, která s původní sdílí nezměněné podstromy. Při chybě alokace
+ * vrátí false a původní verze zůstane beze změny. Každá verze je jen pro
+ * čtení a lze ji bez zámků prohledávat funkcí bst_search, která v tomto
+ * režimu nikdy nerotuje (BST_SPLAY se ignoruje).
+ *
+ * Kopírování cesty používají i bst_insert a bst_delete: *tree nahradí
+ * nová verze a odkaz volajícího na předchozí verzi se uvolní, bst_dispose
+ * odkaz jen uvolní. Ostatní funkce měnící strom na místě (bst_balance,
+ * bst_replace_by_rightmost, ...) se na sdílené verze použít nesmí. Se
+ * zapnutým BST_SPLAY nebo BST_SCAPEGOAT vložení i odstranění selže.
+ */
+bool bst_persistent_insert(bst_node_t *tree, char key, int value,
+                           bst_node_t **version);
+bool bst_persistent_delete(bst_node_t *tree, char key, bst_node_t **version);
+bst_node_t *bst_persistent_retain(bst_node_t *tree);
+void bst_persistent_release(bst_node_t *tree);
+
+// Aktuální verze stromu sdílená zapisujícím a čtoucími vlákny
+typedef struct bst_versions {
+  bst_node_t *root;       // aktuální verze
+  atomic_flag lock;       // krátký zámek pro předání kořene
+} bst_versions_t;
+
+void bst_versions_init(bst_versions_t *versions);
+bst_node_t *bst_versions_snapshot(bst_versions_t *versions);
+void bst_versions_publish(bst_versions_t *versions, bst_node_t *tree);
+bool bst_versions_insert(bst_versions_t *versions, char key, int value);
+bool bst_versions_delete(bst_versions_t *versions, char key);
+void bst_versions_dispose(bst_versions_t *versions);
+#endif
+
 void bst_init(bst_node_t **tree);
 void bst_insert(bst_node_t **tree, char key, int value);
 bool bst_search(bst_node_t *tree, char key, int *value);
@@ -31,15 +196,134 @@ typedef struct bst_items {
 
 void bst_add_node_to_items(bst_node_t* node, bst_items_t *items);
 
+int bst_count_nodes(bst_node_t *node);
+int bst_height(bst_node_t *tree);
+void bst_to_array(bst_node_t *node, bst_items_t *items);
+bst_node_t *array_to_bst(int start, int end, bst_node_t **nodes);
+void bst_rebuild(bst_node_t **tree, int size);
+
 void bst_preorder(bst_node_t *tree, bst_items_t *items);
 void bst_inorder(bst_node_t *tree, bst_items_t *items);
 void bst_postorder(bst_node_t *tree, bst_items_t *items);
 
+// Počáteční kapacita zásobníku iterátoru (bez alokace)
+#define BST_ITER_STACK 32
+
+// Druh průchodu iterátoru
+typedef enum bst_iter_order {
+  BST_ITER_PREORDER,
+  BST_ITER_INORDER,
+  BST_ITER_POSTORDER
+} bst_iter_order_t;
+
+// Iterátor stromu
+typedef struct bst_iter {
+  bst_node_t *root;                          // kořen procházeného stromu
+  bst_iter_order_t order;                    // druh průchodu
+  bst_node_t **nodes;                        // zásobník dosud nevrácených uzlů
+  int capacity;                              // kapacita zásobníku
+  int top;                                   // index vrcholu zásobníku
+  bool failed;                               // alokace zásobníku selhala
+  bst_node_t *inline_nodes[BST_ITER_STACK];  // zásobník pro stromy nízké výšky
+} bst_iter_t;
+
+void bst_iter_begin(bst_iter_t *iter, bst_node_t *tree);
+void bst_iter_begin_preorder(bst_iter_t *iter, bst_node_t *tree);
+void bst_iter_begin_postorder(bst_iter_t *iter, bst_node_t *tree);
+void bst_iter_seek(bst_iter_t *iter, char key);
+bst_node_t *bst_iter_next(bst_iter_t *iter);
+void bst_iter_end(bst_iter_t *iter);
+
+// Zmrazený strom uložený v poli v pořadí Eytzinger
+typedef struct bst_frozen {
+  char *keys;             // klíče, kořen na indexu 1, potomci k na 2k a 2k+1
+  int *values;            // hodnoty na stejných indexech jako klíče
+  int size;               // počet uzlů
+} bst_frozen_t;
+
+void bst_freeze(bst_node_t *tree, bst_frozen_t *frozen);
+bool bst_frozen_search(bst_frozen_t *frozen, char key, int *value);
+void bst_frozen_dispose(bst_frozen_t *frozen);
+
+void bst_search_batch(bst_node_t *tree, const char keys[], int n, int values[],
+                      bool found[]);
+
+// Index chybějícího potomka v kompaktním stromu
+#define BST_COMPACT_NIL UINT32_MAX
+
+// Největší kapacita kompaktního stromu, všechny indexy jsou menší než NIL
+#ifndef BST_COMPACT_MAX
+#define BST_COMPACT_MAX (BST_COMPACT_NIL - 1)
+#endif
+
+// Uzel kompaktního stromu (12 bajtů), klíč je v samostatném poli
+typedef struct bst_compact_node {
+  uint32_t left;          // index levého potomka
+  uint32_t right;         // index pravého potomka
+  int value;              // hodnota
+} bst_compact_node_t;
+
+// Kompaktní strom s uzly v jednom poli a 32bitovými indexy potomků
+typedef struct bst_compact {
+  char *keys;                 // klíče uzlů
+  bst_compact_node_t *nodes;  // uzly na stejných indexech jako klíče
+  uint32_t root;              // index kořene
+  uint32_t free;              // první uvolněný uzel, další jsou v left
+  uint32_t used;              // počet použitých míst v polích
+  uint32_t capacity;          // velikost polí
+} bst_compact_t;
+
+void bst_compact_init(bst_compact_t *tree);
+bool bst_compact_search(bst_compact_t *tree, char key, int *value);
+void bst_compact_insert(bst_compact_t *tree, char key, int value);
+void bst_compact_delete(bst_compact_t *tree, char key);
+void bst_compact_dispose(bst_compact_t *tree);
+void bst_compact_pack(bst_compact_t *compact, bst_node_t *tree);
+bst_node_t *bst_compact_unpack(bst_compact_t *compact);
+
+int bst_size(bst_node_t *tree);
+bst_node_t *bst_select(bst_node_t *tree, int k);
+int bst_rank(bst_node_t *tree, char key);
+
+void bst_range(bst_node_t *tree, char lo, char hi, bst_items_t *items);
+int bst_count_range(bst_node_t *tree, char lo, char hi);
+
 void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree);
 
+bst_node_t *bst_split(bst_node_t *tree, char key, bst_node_t **less,
+                      bst_node_t **greater);
+bst_node_t *bst_join(bst_node_t *less, bst_node_t *greater);
+bst_node_t *bst_union(bst_node_t *a, bst_node_t *b, int (*combine)(int, int));
+int bst_top_k(bst_node_t *tree, int k, bst_node_t *top[]);
+
+// Formát výpisu stromu funkcí bst_dump
+typedef enum bst_dump_format {
+  BST_DUMP_TEXT,          // textový obrázek stromu jako v bst_print_tree
+  BST_DUMP_DOT,           // graf pro Graphviz
+  BST_DUMP_JSON           // vnořené objekty {"key","value","left","right"}
+} bst_dump_format_t;
+
+bool bst_dump(bst_node_t *tree, FILE *out, bst_dump_format_t format);
+#ifdef BST_STATS
+void bst_stats_reset(void);
+void bst_stats_report(FILE *out, const stats_t *stats, bst_node_t *tree);
+#endif
+
 void bst_print_node(bst_node_t *node);
 
 void bst_balance(bst_node_t **tree);
+bool bst_build_sorted(bst_node_t **tree, const char keys[], const int values[],
+                      int count);
+bool bst_build_optimal(bst_node_t **tree, const char keys[],
+                       const int weights[], int count);
 void letter_count(bst_node_t **letter_frequency_tree, char *input);
+void letter_count_update(bst_node_t **tree, const char *input, size_t length);
+bool letter_count_file(bst_node_t **tree, const char *path);
+void letter_count_parallel(bst_node_t **tree, const char *input, size_t length,
+                           int threads);
+// Strom bst_u32 je deklarovaný v gen/bst_gen.h
+struct bst_u32_node;
+void letter_count_utf8(struct bst_u32_node **tree, const char *input,
+                       size_t length);
 
 #endif
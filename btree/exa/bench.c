@@ -0,0 +1,140 @@
+/*
+ * Měření vyhledávání s nerovnoměrným (Zipfovým) rozdělením dotazů
+ * v obyčejném, vyváženém, samoupravujícím (BST_SPLAY) a optimálním
+ * (bst_build_optimal podle četností dotazů) stromu.
+ *
+ * Použití: ./bench [exponent Zipfova rozdělení]
+ */
+#include "../btree.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_KEYS 128
+#define BENCH_QUERIES 20000000
+#define BENCH_DEPTH_QUERIES 1000000
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+static void bench_shuffle(char keys[BENCH_KEYS]) {
+  for (int i = BENCH_KEYS - 1; i > 0; i--) {
+    int j = (int)(bench_random() % (uint64_t)(i + 1));
+    char key = keys[i];
+    keys[i] = keys[j];
+    keys[j] = key;
+  }
+}
+
+/*
+ * Hloubka uzlu s klíčem key (kořen má hloubku 1).
+ */
+static int bench_depth(bst_node_t *tree, char key) {
+  int depth = 1;
+  while (tree != NULL && tree->key != key) {
+    tree = key < tree->key ? tree->left : tree->right;
+    depth++;
+  }
+  return depth;
+}
+
+/*
+ * Změří průměrnou cenu a hloubku dotazů. Hloubka se měří zvlášť, aby
+ * procházení stromu navíc neovlivnilo čas.
+ */
+static void bench_run(const char *name, bst_node_t *tree, const char *queries) {
+  int value;
+  long found = 0;
+  clock_t start = clock();
+  for (int i = 0; i < BENCH_QUERIES; i++) {
+    found += bst_search(tree, queries[i], &value);
+  }
+  double ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / BENCH_QUERIES;
+
+  long depth = 0;
+  for (int i = 0; i < BENCH_DEPTH_QUERIES; i++) {
+    depth += bench_depth(tree, queries[i]);
+    bst_search(tree, queries[i], &value);
+  }
+  printf("%-9s %9.1f %11.2f\n", name, ns, (double)depth / BENCH_DEPTH_QUERIES);
+  if (found != BENCH_QUERIES) {
+    printf("[W] Missing keys\n");
+  }
+}
+
+int main(int argc, char *argv[]) {
+  double exponent = argc > 1 ? atof(argv[1]) : 1.0;
+
+  // Keys in random insertion order, and an independent random order of
+  // popularity, so the hottest key is not simply the root.
+  char keys[BENCH_KEYS];
+  char hot_keys[BENCH_KEYS];
+  int values[BENCH_KEYS];
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    keys[i] = (char)i;
+    hot_keys[i] = (char)i;
+    values[i] = i;
+  }
+  bench_shuffle(keys);
+  bench_shuffle(hot_keys);
+
+  // Zipf distribution: the key of rank r is picked with weight 1/r^s.
+  double cdf[BENCH_KEYS];
+  double total = 0;
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    total += 1 / pow(i + 1, exponent);
+    cdf[i] = total;
+  }
+  char *queries = malloc(BENCH_QUERIES);
+  if (queries == NULL) {
+    return 1;
+  }
+  for (int i = 0; i < BENCH_QUERIES; i++) {
+    double u = (double)(bench_random() >> 11) / (1ULL << 53) * total;
+    int rank = 0;
+    while (rank < BENCH_KEYS - 1 && cdf[rank] < u) {
+      rank++;
+    }
+    queries[i] = hot_keys[rank];
+  }
+
+  printf("Zipf exponent %.2f, %d keys\n", exponent, BENCH_KEYS);
+  printf("%-9s %9s %11s\n", "tree", "ns/search", "avg depth");
+
+  bst_node_t *tree;
+  bst_init(&tree);
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    bst_insert(&tree, keys[i], values[i]);
+  }
+  bench_run("plain", tree, queries);
+  bst_balance(&tree);
+  bench_run("balanced", tree, queries);
+  BST_SPLAY = true;
+  bench_run("splay", tree, queries);
+  BST_SPLAY = false;
+  bst_dispose(&tree);
+
+  // Weights are the query frequencies, as letter_count would count them.
+  int weights[BENCH_KEYS] = {0};
+  for (int i = 0; i < BENCH_QUERIES; i++) {
+    weights[(unsigned char)queries[i]]++;
+  }
+  char sorted_keys[BENCH_KEYS];
+  for (int i = 0; i < BENCH_KEYS; i++) {
+    sorted_keys[i] = (char)i;
+  }
+  bst_build_optimal(&tree, sorted_keys, weights, BENCH_KEYS);
+  bench_run("optimal", tree, queries);
+  bst_dispose(&tree);
+
+  free(queries);
+  return 0;
+}
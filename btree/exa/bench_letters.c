@@ -0,0 +1,168 @@
+/*
+ * Měření propustnosti letter_count a porovnání s původní implementací,
+ * která pro každý znak volá bst_search a bst_insert.
+ *
+ * Paralelní verze se měří pro 1 až 8 vláken, letter_count_utf8 pro
+ * stejný vstup a pro český text.
+ *
+ * Použití: ./bench_letters [velikost vstupu v MB]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "../btree.h"
+#include "../gen/bst_gen.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+/*
+ * Původní implementace letter_count se dvěma průchody stromem na znak.
+ */
+static void bench_letter_count_reference(bst_node_t **tree, char *input) {
+  bst_init(tree);
+  for (int symbol = 0; input[symbol] != '\0'; symbol++) {
+    char key;
+    if ((input[symbol] >= 'a' && input[symbol] <= 'z') ||
+        (input[symbol] >= '0' && input[symbol] <= '9') ||
+        (input[symbol] == ' ')) {
+      key = input[symbol];
+    } else if (input[symbol] >= 'A' && input[symbol] <= 'Z') {
+      key = input[symbol] + 32;
+    } else {
+      key = '_';
+    }
+    int value = 0;
+    if (bst_search(*tree, key, &value)) {
+      bst_insert(tree, key, value + 1);
+    } else {
+      bst_insert(tree, key, 1);
+    }
+  }
+}
+
+/*
+ * Porovná tvar, klíče a hodnoty dvou stromů.
+ */
+static bool bench_same_tree(bst_node_t *a, bst_node_t *b) {
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  return a->key == b->key && a->value == b->value &&
+         bench_same_tree(a->left, b->left) &&
+         bench_same_tree(a->right, b->right);
+}
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+  long megabytes = argc > 1 ? atol(argv[1]) : 256;
+  size_t length = (size_t)megabytes << 20;
+
+  // Text-like input: mostly lowercase letters and spaces, some upper
+  // case, digits, punctuation and bytes above 127.
+  const char alphabet[] = "etaoinshrdlucmfwypvbgkqjxz        ETAOINS0123.,;!";
+  char *input = malloc(length + 1);
+  if (input == NULL) {
+    return 1;
+  }
+  for (size_t i = 0; i < length; i++) {
+    uint64_t r = bench_random();
+    input[i] = (r & 0xff) == 0 ? (char)(0x80 | (r >> 8 & 0x7f))
+                               : alphabet[(r >> 16) % (sizeof(alphabet) - 1)];
+  }
+  input[length] = '\0';
+
+  printf("%-10s %9s %9s\n", "version", "seconds", "MB/s");
+  bst_node_t *tree;
+  double start = bench_now();
+  letter_count(&tree, input);
+  double seconds = bench_now() - start;
+  printf("%-10s %9.3f %9.1f\n", "table", seconds, megabytes / seconds);
+
+  bool parallel_matches = true;
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    bst_node_t *parallel_tree;
+    start = bench_now();
+    letter_count_parallel(&parallel_tree, input, length, threads);
+    seconds = bench_now() - start;
+    char name[16];
+    snprintf(name, sizeof(name), "%d threads", threads);
+    printf("%-10s %9.3f %9.1f\n", name, seconds, megabytes / seconds);
+    parallel_matches &= bench_same_tree(tree, parallel_tree);
+    bst_dispose(&parallel_tree);
+  }
+
+  // The reference takes long, so it runs on a prefix only.
+  size_t prefix = length < ((size_t)16 << 20) ? length : (size_t)16 << 20;
+  char saved = input[prefix];
+  input[prefix] = '\0';
+  bst_node_t *reference;
+  bst_node_t *prefix_tree;
+  start = bench_now();
+  bench_letter_count_reference(&reference, input);
+  seconds = bench_now() - start;
+  printf("%-10s %9.3f %9.1f\n", "reference", seconds,
+         (double)(prefix >> 20) / seconds);
+  letter_count(&prefix_tree, input);
+  input[prefix] = saved;
+
+  if (!bench_same_tree(reference, prefix_tree) || !parallel_matches) {
+    printf("[W] Results of the implementations differ\n");
+  }
+  bst_dispose(&tree);
+  bst_dispose(&reference);
+  bst_dispose(&prefix_tree);
+
+  bst_u32_node_t *utf8_tree;
+  bst_u32_init(&utf8_tree);
+  start = bench_now();
+  letter_count_utf8(&utf8_tree, input, length);
+  seconds = bench_now() - start;
+  printf("%-10s %9.3f %9.1f\n", "utf8 ascii", seconds, megabytes / seconds);
+  bst_u32_dispose(&utf8_tree);
+
+  // Czech text, about every tenth character is outside ASCII.
+  const char *words[] = {"P\xc5\x99\xc3\xadli\xc5\xa1 ",
+                         "\xc5\xbelu\xc5\xa5ou\xc4\x8dk\xc3\xbd ",
+                         "k\xc5\xaf\xc5\x88 ", "\xc3\xbap\xc4\x9bl ",
+                         "\xc4\x8f\xc3\xa1" "belsk\xc3\xa9 ",
+                         "\xc3\xb3" "dy. ", "a ", "se ", "na ", "tento ",
+                         "kdy\xc5\xbe ", "ale ", "proto ", "jsme ",
+                         "v\xc5\xa1" "ak ", "jen ", "tak\xc3\xa9 ",
+                         "Praha ", "strom ", "hodnota "};
+  size_t word_count = sizeof(words) / sizeof(words[0]);
+  size_t filled = 0;
+  while (filled < length) {
+    const char *word = words[bench_random() % word_count];
+    size_t word_length = strlen(word);
+    if (filled + word_length > length) {
+      word_length = length - filled;
+    }
+    memcpy(input + filled, word, word_length);
+    filled += word_length;
+  }
+  bst_u32_init(&utf8_tree);
+  start = bench_now();
+  letter_count_utf8(&utf8_tree, input, length);
+  seconds = bench_now() - start;
+  printf("%-10s %9.3f %9.1f\n", "utf8 czech", seconds, megabytes / seconds);
+  bst_u32_dispose(&utf8_tree);
+
+  free(input);
+  return 0;
+}
@@ -8,10 +8,181 @@
  * 
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "../btree.h"
+#include "../gen/bst_gen.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// Délka bloku vstupu, počty v bloku se vejdou do uint32_t
+#define LETTER_BLOCK 65536
+
+// Velikost bufferu pro čtení souboru v letter_count_file
+#define LETTER_FILE_BUFFER (1 << 20)
+
+// Počty výskytů klíčů pro letter_count
+typedef struct letter_histogram {
+    uint64_t counts[256];   // počet výskytů každého klíče
+    bool seen[256];         // klíč je už v poli order
+    char order[256];        // klíče v pořadí prvního výskytu
+    int order_size;         // počet klíčů v poli order
+} letter_histogram_t;
+
+// Klíč stromu pro každý bajt vstupu (viz letter_count)
+static const char letter_keys[256] = {
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    ' ', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '_', '_', '_', '_', '_', '_',
+    '_', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '_', '_', '_', '_', '_',
+    '_', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+    '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_', '_',
+};
+
+/*
+ * Pomocná funkce která inicializuje histogram pro letter_count.
+ */
+static void letter_histogram_init(letter_histogram_t *histogram) {
+    memset(histogram, 0, sizeof(letter_histogram_t));
+}
+
+/*
+ * Pomocná funkce která přičte do histogramu bajty input[0..length-1].
+ *
+ * Vnitřní smyčka jen počítá bajty do čtyř dílčích histogramů, které se
+ * střídají po bajtech. Po sobě jdoucí stejné bajty tak nezvyšují stejný
+ * čítač a nečekají jeden na druhý (store forwarding). Klíče se z bajtů
+ * určí až tabulkou letter_keys při sečtení bloku. Blok, ve kterém se
+ * objeví nový klíč, se projde ještě jednou znak po znaku, aby se
+ * zachovalo pořadí prvních výskytů a tedy i tvar stromu. To se stane
+ * nejvýše jednou pro každý klíč.
+ *
+ * Vektorová klasifikace (AVX2) s počítáním 38 tříd porovnáním celého
+ * vektoru byla pomalejší než tato tabulka, potřebuje 76 vektorových
+ * operací na 32 bajtů. Proto se používá jen skalární cesta.
+ */
+static void letter_histogram_add(letter_histogram_t *histogram,
+                                 const unsigned char *input, size_t length) {
+    while (length > 0) {
+        size_t block = length < LETTER_BLOCK ? length : LETTER_BLOCK;
+        uint32_t counts[4][256] = {{0}};
+
+        size_t i = 0;
+        for (; i + 4 <= block; i += 4) {
+            counts[0][input[i]]++;
+            counts[1][input[i + 1]]++;
+            counts[2][input[i + 2]]++;
+            counts[3][input[i + 3]]++;
+        }
+        for (; i < block; i++) {
+            counts[0][input[i]]++;
+        }
+
+        bool new_key = false;
+        for (int byte = 0; byte < 256; byte++) {
+            uint32_t count = counts[0][byte] + counts[1][byte] +
+                             counts[2][byte] + counts[3][byte];
+            unsigned char key = (unsigned char)letter_keys[byte];
+            histogram->counts[key] += count;
+            if (count > 0 && !histogram->seen[key]) {
+                new_key = true;
+            }
+        }
+
+        if (new_key) {
+            for (i = 0; i < block; i++) {
+                unsigned char key = (unsigned char)letter_keys[input[i]];
+                if (!histogram->seen[key]) {
+                    histogram->seen[key] = true;
+                    histogram->order[histogram->order_size++] = (char)key;
+                }
+            }
+        }
+
+        input += block;
+        length -= block;
+    }
+}
 
+/*
+ * Pomocná funkce která vrátí součet hodnoty ve stromu a počtu výskytů.
+ * Počty velkých vstupů se nepřetečou, součet je nejvýše INT_MAX.
+ */
+static int letter_add_count(int value, uint64_t count) {
+    int64_t sum = value + (int64_t)(count > INT_MAX ? INT_MAX : count);
+    return sum > INT_MAX ? INT_MAX : (int)sum;
+}
+
+/*
+ * Pomocná funkce která vloží počty z histogramu do stromu.
+ *
+ * Klíče se vkládají v pořadí prvních výskytů, strom má tedy stejný tvar,
+ * jako kdyby se vkládalo po znacích. Klíč, který už ve stromu je,
+ * dostane součet původní a nové hodnoty, nejvýše však INT_MAX.
+ */
+static void letter_histogram_emit(letter_histogram_t *histogram, bst_node_t **tree) {
+    for (int i = 0; i < histogram->order_size; i++) {
+        char key = histogram->order[i];
+        int value = 0;
+        bst_search(*tree, key, &value);
+        uint64_t count = histogram->counts[(unsigned char)key];
+        bst_insert(tree, key, letter_add_count(value, count));
+    }
+}
+
+/*
+ * Pomocná funkce která přičte histogram src do histogramu dst.
+ *
+ * Klíče z src, které v dst ještě nejsou, se připojí na konec pořadí
+ * prvních výskytů. Slučují-li se histogramy po sobě jdoucích úseků vstupu
+ * postupně od prvního, vznikne stejný histogram jako pro celý vstup.
+ */
+static void letter_histogram_merge(letter_histogram_t *dst,
+                                   const letter_histogram_t *src) {
+    for (int key = 0; key < 256; key++) {
+        dst->counts[key] += src->counts[key];
+    }
+    for (int i = 0; i < src->order_size; i++) {
+        unsigned char key = (unsigned char)src->order[i];
+        if (!dst->seen[key]) {
+            dst->seen[key] = true;
+            dst->order[dst->order_size++] = (char)key;
+        }
+    }
+}
+
+// Úsek vstupu zpracovaný jedním vláknem letter_count_parallel
+typedef struct letter_chunk {
+    const unsigned char *input;     // začátek úseku
+    size_t length;                  // délka úseku
+    letter_histogram_t histogram;   // počty v úseku
+} letter_chunk_t;
+
+/*
+ * Pomocná funkce vlákna letter_count_parallel.
+ */
+static void *letter_chunk_count(void *arg) {
+    letter_chunk_t *chunk = arg;
+    letter_histogram_init(&chunk->histogram);
+    letter_histogram_add(&chunk->histogram, chunk->input, chunk->length);
+    return NULL;
+}
 
 /**
  * Vypočítání frekvence výskytů znaků ve vstupním řetězci.
@@ -35,44 +206,460 @@ void letter_count(bst_node_t **tree, char *input) {
     // Initialize the tree.
     bst_init(tree);
 
-    // Iterate over the input string.
-    for (int symbol = 0; input[symbol] != '\0'; symbol++)
-    {
-        char key;
-        
-        if ((input[symbol] >= 'a' && input[symbol] <= 'z')|| // Check if the symbol is lowercase letter.
-            (input[symbol] >= '0' && input[symbol] <= '9')|| // Or the symbol is a number.
-            (input[symbol] == ' '))                          // or the symbol is a space.
-        {
-            key = input[symbol];
-        }
-        // Check if the symbol is uppercase letter.
-        else if  (input[symbol] >= 'A' && input[symbol] <= 'Z')
-        {
-            key = input[symbol] + 32;
-        }
-        // Check if the letter is a special character.
-        else
-        {
-            key = '_';
-        }
-        
-        // Search for the key in the tree.
-        int value = 0;
-        if (bst_search(*tree, key, &value))
-        {
-            // If the key is in the tree, increment the value.
-            value++;
-            bst_insert(tree, key, value);
+    letter_count_update(tree, input, strlen(input));
+}
+
+/*
+ * Přičtení frekvence výskytů znaků input[0..length-1] do stromu.
+ *
+ * Na rozdíl od letter_count strom neinicializuje, počty se přičtou
+ * k hodnotám, které už ve stromu jsou. Postupným voláním pro po sobě
+ * jdoucí části vstupu vznikne stejný strom jako voláním letter_count pro
+ * celý vstup. Vstup nemusí být ukončený nulou.
+ */
+void letter_count_update(bst_node_t **tree, const char *input, size_t length) {
+    letter_histogram_t histogram;
+    letter_histogram_init(&histogram);
+    letter_histogram_add(&histogram, (const unsigned char *)input, length);
+    letter_histogram_emit(&histogram, tree);
+}
+
+/*
+ * Přičtení frekvence výskytů znaků v souboru path do stromu.
+ *
+ * Soubor se čte po blocích délky LETTER_FILE_BUFFER, paměť tedy nezávisí
+ * na velikosti souboru. Strom se neinicializuje (viz letter_count_update)
+ * a vytvoří se jednou po přečtení celého souboru. Pokud se soubor nepodaří
+ * otevřít nebo přečíst, strom se nezmění a funkce vrátí false.
+ */
+bool letter_count_file(bst_node_t **tree, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    char *buffer = malloc(LETTER_FILE_BUFFER);
+    if (buffer == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    letter_histogram_t histogram;
+    letter_histogram_init(&histogram);
+    size_t length;
+    while ((length = fread(buffer, 1, LETTER_FILE_BUFFER, file)) > 0) {
+        letter_histogram_add(&histogram, (const unsigned char *)buffer, length);
+    }
+    bool ok = !ferror(file);
+    if (ok) {
+        letter_histogram_emit(&histogram, tree);
+    }
+
+    free(buffer);
+    fclose(file);
+    return ok;
+}
+
+// Kódový bod, kterým se počítají neplatné posloupnosti UTF-8
+#define LETTER_UTF8_INVALID 0xFFFD
+// Kódové body menší než tato hodnota (1 a 2 bajty UTF-8) se počítají v poli
+#define LETTER_UTF8_DENSE 0x800
+// Počáteční kapacita tabulky ostatních kódových bodů (mocnina dvou)
+#define LETTER_UTF8_SPARSE 64
+
+// Malá písmena pro kódové body U+00C0 až U+017F (Latin-1, Latin Extended-A)
+static const uint16_t letter_utf8_lower[192] = {
+    0x0E0, 0x0E1, 0x0E2, 0x0E3, 0x0E4, 0x0E5, 0x0E6, 0x0E7,
+    0x0E8, 0x0E9, 0x0EA, 0x0EB, 0x0EC, 0x0ED, 0x0EE, 0x0EF,
+    0x0F0, 0x0F1, 0x0F2, 0x0F3, 0x0F4, 0x0F5, 0x0F6, 0x0D7,
+    0x0F8, 0x0F9, 0x0FA, 0x0FB, 0x0FC, 0x0FD, 0x0FE, 0x0DF,
+    0x0E0, 0x0E1, 0x0E2, 0x0E3, 0x0E4, 0x0E5, 0x0E6, 0x0E7,
+    0x0E8, 0x0E9, 0x0EA, 0x0EB, 0x0EC, 0x0ED, 0x0EE, 0x0EF,
+    0x0F0, 0x0F1, 0x0F2, 0x0F3, 0x0F4, 0x0F5, 0x0F6, 0x0F7,
+    0x0F8, 0x0F9, 0x0FA, 0x0FB, 0x0FC, 0x0FD, 0x0FE, 0x0FF,
+    0x101, 0x101, 0x103, 0x103, 0x105, 0x105, 0x107, 0x107,
+    0x109, 0x109, 0x10B, 0x10B, 0x10D, 0x10D, 0x10F, 0x10F,
+    0x111, 0x111, 0x113, 0x113, 0x115, 0x115, 0x117, 0x117,
+    0x119, 0x119, 0x11B, 0x11B, 0x11D, 0x11D, 0x11F, 0x11F,
+    0x121, 0x121, 0x123, 0x123, 0x125, 0x125, 0x127, 0x127,
+    0x129, 0x129, 0x12B, 0x12B, 0x12D, 0x12D, 0x12F, 0x12F,
+    0x130, 0x131, 0x133, 0x133, 0x135, 0x135, 0x137, 0x137,
+    0x138, 0x13A, 0x13A, 0x13C, 0x13C, 0x13E, 0x13E, 0x140,
+    0x140, 0x142, 0x142, 0x144, 0x144, 0x146, 0x146, 0x148,
+    0x148, 0x149, 0x14B, 0x14B, 0x14D, 0x14D, 0x14F, 0x14F,
+    0x151, 0x151, 0x153, 0x153, 0x155, 0x155, 0x157, 0x157,
+    0x159, 0x159, 0x15B, 0x15B, 0x15D, 0x15D, 0x15F, 0x15F,
+    0x161, 0x161, 0x163, 0x163, 0x165, 0x165, 0x167, 0x167,
+    0x169, 0x169, 0x16B, 0x16B, 0x16D, 0x16D, 0x16F, 0x16F,
+    0x171, 0x171, 0x173, 0x173, 0x175, 0x175, 0x177, 0x177,
+    0x0FF, 0x17A, 0x17A, 0x17C, 0x17C, 0x17E, 0x17E, 0x17F,
+};
+
+// Počty kódových bodů od LETTER_UTF8_DENSE (otevřené adresování)
+typedef struct letter_utf8_sparse {
+    uint32_t *keys;         // kódové body, 0 označuje volné místo
+    uint64_t *counts;       // počty výskytů kódových bodů
+    size_t capacity;        // velikost polí, mocnina dvou
+    size_t size;            // počet obsazených míst
+    bool failed;            // nějaký kódový bod se nepodařilo započítat
+} letter_utf8_sparse_t;
+
+// Počty výskytů kódových bodů pro letter_count_utf8
+typedef struct letter_utf8_histogram {
+    uint64_t ascii[128];                // počty ASCII bajtů
+    uint64_t dense[LETTER_UTF8_DENSE];  // počty kódových bodů U+0080 až U+07FF
+    letter_utf8_sparse_t sparse;        // počty ostatních kódových bodů
+} letter_utf8_histogram_t;
+
+/*
+ * Pomocná funkce která dekóduje jeden znak UTF-8 ze začátku vstupu
+ * a vrátí počet přečtených bajtů (alespoň 1).
+ *
+ * Přípustné bajty odpovídají tabulce 3-7 standardu Unicode, neplatná je
+ * tedy i zbytečně dlouhá posloupnost, zakódovaná náhrada (surrogate)
+ * a kódový bod nad U+10FFFF. Neplatná posloupnost se přečte jen po první
+ * nevyhovující bajt a dekóduje se jako LETTER_UTF8_INVALID.
+ */
+static size_t letter_utf8_decode(const unsigned char *input, size_t length,
+                                 uint32_t *code_point) {
+    unsigned char lead = input[0];
+    size_t size;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        size = 2;
+        *code_point = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        size = 3;
+        *code_point = lead & 0x0F;
+        if (lead == 0xE0) {
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            high = 0x9F;
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        size = 4;
+        *code_point = lead & 0x07;
+        if (lead == 0xF0) {
+            low = 0x90;
+        } else if (lead == 0xF4) {
+            high = 0x8F;
+        }
+    } else {
+        *code_point = LETTER_UTF8_INVALID;
+        return 1;
+    }
+
+    for (size_t i = 1; i < size; i++) {
+        if (i == length || input[i] < low || input[i] > high) {
+            *code_point = LETTER_UTF8_INVALID;
+            return i;
+        }
+        *code_point = (*code_point << 6) | (input[i] & 0x3F);
+        low = 0x80;
+        high = 0xBF;
+    }
+    return size;
+}
+
+/*
+ * Pomocná funkce která vrátí místo kódového bodu v tabulce sparse, nebo
+ * volné místo, kam patří (lineární sondování).
+ */
+static size_t letter_utf8_slot(const letter_utf8_sparse_t *sparse,
+                               uint32_t code_point) {
+    size_t mask = sparse->capacity - 1;
+    size_t slot = (code_point * 2654435761u >> 16) & mask;
+    while (sparse->keys[slot] != 0 && sparse->keys[slot] != code_point) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * Pomocná funkce která zdvojnásobí kapacitu tabulky sparse. Při chybě
+ * alokace vrátí false a tabulka zůstane beze změny.
+ */
+static bool letter_utf8_grow(letter_utf8_sparse_t *sparse) {
+    letter_utf8_sparse_t grown = *sparse;
+    grown.capacity = sparse->capacity == 0 ? LETTER_UTF8_SPARSE
+                                           : sparse->capacity * 2;
+    grown.keys = calloc(grown.capacity, sizeof(uint32_t));
+    grown.counts = malloc(grown.capacity * sizeof(uint64_t));
+    if (grown.keys == NULL || grown.counts == NULL) {
+        free(grown.keys);
+        free(grown.counts);
+        return false;
+    }
+    for (size_t i = 0; i < sparse->capacity; i++) {
+        if (sparse->keys[i] != 0) {
+            size_t slot = letter_utf8_slot(&grown, sparse->keys[i]);
+            grown.keys[slot] = sparse->keys[i];
+            grown.counts[slot] = sparse->counts[i];
+        }
+    }
+    free(sparse->keys);
+    free(sparse->counts);
+    *sparse = grown;
+    return true;
+}
+
+/*
+ * Pomocná funkce která započítá jeden znak mimo ASCII.
+ *
+ * Kódové body od LETTER_UTF8_DENSE se počítají v hašovací tabulce a do
+ * stromu se vloží až jednou na konci. Pokud se tabulku nepodaří zvětšit,
+ * plní se dál, dokud v ní zbývá volné místo, a potom se nastaví failed.
+ */
+static void letter_utf8_count(letter_utf8_histogram_t *histogram,
+                              uint32_t code_point) {
+    if (code_point >= 0xC0 && code_point < 0x180) {
+        code_point = letter_utf8_lower[code_point - 0xC0];
+    }
+    if (code_point < LETTER_UTF8_DENSE) {
+        histogram->dense[code_point]++;
+        return;
+    }
+
+    letter_utf8_sparse_t *sparse = &histogram->sparse;
+    if ((sparse->size + 1) * 2 > sparse->capacity && !letter_utf8_grow(sparse) &&
+        sparse->size + 1 >= sparse->capacity) {
+        sparse->failed = true;
+        return;
+    }
+    size_t slot = letter_utf8_slot(sparse, code_point);
+    if (sparse->keys[slot] == 0) {
+        sparse->keys[slot] = code_point;
+        sparse->counts[slot] = 0;
+        sparse->size++;
+    }
+    sparse->counts[slot]++;
+}
+
+/*
+ * Pomocná funkce pro qsort, která porovná kódové body.
+ */
+static int letter_utf8_compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Pomocná funkce která přičte do histogramu znaky input[0..length-1].
+ *
+ * Úseky ASCII se hledají po 8 bajtech v jednom registru (SWAR, bez
+ * vektorových instrukcí): 64bitové slovo bez nejvyššího bitu v žádném
+ * bajtu je celé ASCII a jeho bajty se počítají do dílčích
+ * histogramů jako v letter_histogram_add. Ostatní znaky se dekódují
+ * funkcí letter_utf8_decode.
+ */
+static void letter_utf8_add(letter_utf8_histogram_t *histogram,
+                            const unsigned char *input, size_t length) {
+    size_t i = 0;
+    while (i < length) {
+        size_t end = length - i < LETTER_BLOCK ? length : i + LETTER_BLOCK;
+        uint32_t counts[4][128] = {{0}};
+
+        while (i < end) {
+            while (i + 8 <= end) {
+                uint64_t word;
+                memcpy(&word, input + i, sizeof(word));
+                if (word & 0x8080808080808080ULL) {
+                    break;
+                }
+                counts[0][input[i]]++;
+                counts[1][input[i + 1]]++;
+                counts[2][input[i + 2]]++;
+                counts[3][input[i + 3]]++;
+                counts[0][input[i + 4]]++;
+                counts[1][input[i + 5]]++;
+                counts[2][input[i + 6]]++;
+                counts[3][input[i + 7]]++;
+                i += 8;
+            }
+            // The rest of the word up to the first byte above 127.
+            while (i < end && input[i] < 0x80) {
+                counts[0][input[i]]++;
+                i++;
+            }
+            if (i == end) {
+                break;
+            }
+            // A character may end past the block, the block only limits
+            // the counts.
+            uint32_t code_point;
+            if (input[i] >= 0xC2 && input[i] <= 0xDF && i + 1 < length &&
+                (input[i + 1] & 0xC0) == 0x80) {
+                // Two-byte characters cover all Central European letters.
+                code_point = (input[i] & 0x1F) << 6 | (input[i + 1] & 0x3F);
+                i += 2;
+            } else {
+                i += letter_utf8_decode(input + i, length - i, &code_point);
+            }
+            letter_utf8_count(histogram, code_point);
         }
-        else
-        {
-            // If the key is not in the tree, insert it.
-            bst_insert(tree, key, 1);
+
+        for (int byte = 0; byte < 128; byte++) {
+            histogram->ascii[byte] += counts[0][byte] + counts[1][byte] +
+                                      counts[2][byte] + counts[3][byte];
         }
     }
 }
 
+/*
+ * Pomocná funkce která vloží do stromu klíče keys[start..end-1] s počty
+ * counts tak, aby nové klíče tvořily vyvážený podstrom.
+ */
+static void letter_utf8_insert(bst_u32_node_t **tree, const uint32_t keys[],
+                               const uint64_t counts[], size_t start,
+                               size_t end) {
+    if (start >= end) {
+        return;
+    }
+    size_t mid = start + (end - start) / 2;
+    int value = 0;
+    bst_u32_search(*tree, keys[mid], &value);
+    bst_u32_insert(tree, keys[mid], letter_add_count(value, counts[mid]));
+    letter_utf8_insert(tree, keys, counts, start, mid);
+    letter_utf8_insert(tree, keys, counts, mid + 1, end);
+}
+
+/*
+ * Přičtení frekvence výskytů znaků textu v UTF-8 do stromu s klíči
+ * kódových bodů.
+ *
+ * Znaky ASCII se počítají stejně jako v letter_count, tedy s klíči
+ * 'a'-'z' (bez ohledu na velikost), '0'-'9', ' ' a '_' pro ostatní znaky.
+ * Znaky mimo ASCII se počítají podle kódového bodu, velká písmena
+ * z bloků Latin-1 a Latin Extended-A (včetně všech písmen češtiny,
+ * slovenštiny, polštiny a maďarštiny) se převedou na malá tabulkou
+ * letter_utf8_lower. Neplatné posloupnosti bajtů se počítají jako U+FFFD.
+ *
+ * Strom musí být inicializovaný, počty se přičtou k hodnotám, které už ve
+ * stromu jsou. Nové klíče se vloží tak, aby tvořily vyvážený strom.
+ * Vstup nemusí být ukončený nulou. Při chybě alokace zůstane strom beze
+ * změny.
+ */
+void letter_count_utf8(bst_u32_node_t **tree, const char *input,
+                       size_t length) {
+    letter_utf8_histogram_t *histogram =
+        calloc(1, sizeof(letter_utf8_histogram_t));
+    if (histogram == NULL) {
+        return;
+    }
+    letter_utf8_add(histogram, (const unsigned char *)input, length);
+    for (int byte = 0; byte < 128; byte++) {
+        histogram->dense[(unsigned char)letter_keys[byte]] +=
+            histogram->ascii[byte];
+    }
+
+    letter_utf8_sparse_t *sparse = &histogram->sparse;
+    size_t capacity = LETTER_UTF8_DENSE + sparse->size;
+    uint32_t *keys = malloc(capacity * sizeof(uint32_t));
+    uint64_t *counts = malloc(capacity * sizeof(uint64_t));
+    if (!sparse->failed && keys != NULL && counts != NULL) {
+        size_t count = 0;
+        for (uint32_t code_point = 0; code_point < LETTER_UTF8_DENSE;
+             code_point++) {
+            if (histogram->dense[code_point] > 0) {
+                keys[count] = code_point;
+                counts[count] = histogram->dense[code_point];
+                count++;
+            }
+        }
+        // Dense code points are smaller than all sparse ones, only the
+        // sparse ones need sorting.
+        size_t dense_count = count;
+        for (size_t i = 0; i < sparse->capacity; i++) {
+            if (sparse->keys[i] != 0) {
+                keys[count++] = sparse->keys[i];
+            }
+        }
+        qsort(keys + dense_count, count - dense_count, sizeof(uint32_t),
+              letter_utf8_compare);
+        for (size_t i = dense_count; i < count; i++) {
+            counts[i] = sparse->counts[letter_utf8_slot(sparse, keys[i])];
+        }
+        letter_utf8_insert(tree, keys, counts, 0, count);
+    }
+
+    free(keys);
+    free(counts);
+    free(sparse->keys);
+    free(sparse->counts);
+    free(histogram);
+}
+
+/*
+ * Vypočítání frekvence výskytů znaků paralelně v threads vláknech.
+ *
+ * Výsledný strom je stejný jako po volání letter_count pro prvních length
+ * znaků vstupu (vstup nemusí být ukončený nulou). Vstup se rozdělí na
+ * souvislé úseky, každé vlákno spočítá svůj úsek do vlastního histogramu
+ * a histogramy se sečtou v pořadí úseků, takže se zachová i pořadí
+ * prvních výskytů a tedy tvar stromu. Strom se vytvoří jednou na konci.
+ *
+ * Pokud threads není kladné, použije se počet procesorů. Úsek je dlouhý
+ * alespoň LETTER_BLOCK znaků, krátký vstup proto zpracuje méně vláken.
+ * Úseky vláken, která se nepodaří spustit, zpracuje volající vlákno.
+ */
+void letter_count_parallel(bst_node_t **tree, const char *input, size_t length,
+                           int threads) {
+    bst_init(tree);
+
+    if (threads <= 0) {
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    size_t max_threads = length / LETTER_BLOCK + 1;
+    if (threads <= 0) {
+        threads = 1;
+    } else if ((size_t)threads > max_threads) {
+        threads = (int)max_threads;
+    }
+
+    letter_chunk_t *chunks = malloc(threads * sizeof(letter_chunk_t));
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    bool *started = calloc(threads, sizeof(bool));
+    if (chunks == NULL || workers == NULL || started == NULL) {
+        free(chunks);
+        free(workers);
+        free(started);
+        return;
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < threads; i++) {
+        size_t end = length / threads * (i + 1);
+        if (i == threads - 1) {
+            end = length;
+        }
+        chunks[i].input = (const unsigned char *)input + offset;
+        chunks[i].length = end - offset;
+        offset = end;
+    }
+
+    // The calling thread counts the first chunk itself.
+    for (int i = 1; i < threads; i++) {
+        started[i] = pthread_create(&workers[i], NULL, letter_chunk_count,
+                                    &chunks[i]) == 0;
+    }
+    letter_chunk_count(&chunks[0]);
+    for (int i = 1; i < threads; i++) {
+        if (started[i]) {
+            pthread_join(workers[i], NULL);
+        } else {
+            letter_chunk_count(&chunks[i]);
+        }
+        letter_histogram_merge(&chunks[0].histogram, &chunks[i].histogram);
+    }
+    letter_histogram_emit(&chunks[0].histogram, tree);
+
+    free(chunks);
+    free(workers);
+    free(started);
+}
+
 
 
 /**
@@ -86,48 +673,62 @@ void letter_count(bst_node_t **tree, char *input) {
  * Pro implementaci si můžete v tomto souboru nadefinovat vlastní pomocné funkce. Není nutné, aby funkce fungovala *in situ* (in-place).
 */
 
-int bst_count_nodes(bst_node_t *node) {
-    if (node == NULL) {
-        return 0;
-    }
-    return bst_count_nodes(node->left) + bst_count_nodes(node->right) + 1;
-}
+/*
+ * Pomocná funkce která narovná strom do "páteře" pravých potomků.
+ *
+ * Každý levý potomek se rotací doprava přesune nad svého rodiče, takže
+ * výsledkem je seznam uzlů ve vzestupném pořadí spojený ukazateli right.
+ * Vrací počet uzlů.
+ */
+static int bst_to_vine(bst_node_t **tree) {
+    int count = 0;
+    bst_node_t **link = tree;
 
-void bst_to_array(bst_node_t *node, bst_items_t *items) {
-    // Base case
-    if (node == NULL)
-        return;
-    
-    // Recursively convert the left subtree
-    bst_to_array(node->left, items);
-    
-    // Add the current node to the array of items
-    if (items->size < items->capacity) {
-        items->nodes[items->size++] = node;
+    while (*link != NULL) {
+        if ((*link)->left != NULL) {
+            // Rotate right, the left child takes the place of its parent.
+            bst_node_t *left = (*link)->left;
+            (*link)->left = left->right;
+            left->right = *link;
+            BST_UPDATE_SIZE(left->right);
+            BST_UPDATE_SIZE(left);
+            *link = left;
+        } else {
+            count++;
+            link = &((*link)->right);
+        }
     }
-    
-    // Recursively convert the right subtree
-    bst_to_array(node->right, items);
+    return count;
 }
 
-bst_node_t* array_to_bst(int start, int end, bst_node_t **nodes) {
-    // Base case
-    if (start > end)
-        return NULL;
-    
-    // Get the middle element and make it root
-    int mid = (start + end) / 2;
-    bst_node_t *root = nodes[mid];
-    
-    // Recursively construct the left subtree
-    root->left = array_to_bst(start, mid - 1, nodes);
-    
-    // Recursively construct the right subtree
-    root->right = array_to_bst(mid + 1, end, nodes);
-    
-    return root;
+/*
+ * Pomocná funkce která provede count rotací doleva podél páteře.
+ *
+ * Každý druhý uzel páteře se stane levým potomkem následujícího uzlu.
+ */
+static void bst_vine_compress(bst_node_t **tree, int count) {
+    bst_node_t **link = tree;
+
+    for (int i = 0; i < count; i++) {
+        bst_node_t *child = *link;
+        bst_node_t *grandchild = child->right;
+        child->right = grandchild->left;
+        grandchild->left = child;
+        BST_UPDATE_SIZE(child);
+        BST_UPDATE_SIZE(grandchild);
+        *link = grandchild;
+        link = &(grandchild->right);
+    }
 }
 
+/*
+ * Vyvážení stromu algoritmem Day–Stout–Warren.
+ *
+ * Strom se nejdříve rotacemi narovná do páteře a ta se opakovanými
+ * rotacemi doleva složí do stromu, jehož listy leží nejvýše na dvou
+ * posledních úrovních. Funkce pracuje in situ s O(1) pomocné paměti
+ * a v čase O(n).
+ */
 void bst_balance(bst_node_t **tree) {
     if (tree == NULL)
     {
@@ -137,29 +738,168 @@ void bst_balance(bst_node_t **tree) {
     {
         return;
     }
-    
-    // Count the total number of nodes in the tree.
-    int total_nodes = bst_count_nodes(*tree);
 
-    // Initialize the array to hold the nodes.
-    bst_items_t items;
-    // bst_init_items(&items);
+    int count = bst_to_vine(tree);
 
-    items.capacity = total_nodes;
-    items.size = 0;
-    items.nodes = malloc(items.capacity * sizeof(bst_node_t*));
-    
-    // Memory allocation error.
-    if (items.nodes == NULL) {
-        return;
+    // Nodes above the largest perfect tree go to the bottom level first.
+    int perfect = 1;
+    while (perfect * 2 <= count + 1) {
+        perfect *= 2;
+    }
+    bst_vine_compress(tree, count + 1 - perfect);
+
+    count = perfect - 1;
+    while (count > 1) {
+        count /= 2;
+        bst_vine_compress(tree, count);
+    }
+}
+
+/*
+ * Pomocná funkce která z úseku seřazených klíčů vytvoří vyvážený podstrom
+ * *tree. Při chybě alokace uvolní již vytvořené uzly podstromu, nastaví
+ * *tree na NULL a vrátí false.
+ */
+static bool sorted_to_bst(int start, int end, const char keys[],
+                          const int values[], bst_node_t **tree) {
+    *tree = NULL;
+    // Base case
+    if (start > end)
+        return true;
+
+    // Get the middle element and make it root
+    int mid = (start + end) / 2;
+    bst_node_t *root = bst_node_alloc();
+    if (root == NULL)
+        return false;
+    root->key = keys[mid];
+    root->value = values[mid];
+    root->left = NULL;
+    root->right = NULL;
+
+    if (!sorted_to_bst(start, mid - 1, keys, values, &root->left) ||
+        !sorted_to_bst(mid + 1, end, keys, values, &root->right)) {
+        bst_dispose(&root);
+        return false;
     }
-    
-    // Convert the BST to a sorted array of nodes
-    bst_to_array(*tree, &items);
-    
-    // Build a balanced BST from the sorted array of nodes
-    *tree = array_to_bst(0, items.size - 1, items.nodes);
-    
-    // Free the temporary array memory
-    free(items.nodes);
+
+    BST_UPDATE_SIZE(root);
+    *tree = root;
+    return true;
+}
+
+/*
+ * Vytvoření vyváženého stromu ze seřazených dat.
+ *
+ * Klíče musí být ostře rostoucí. Každý uzel se vytvoří právě jednou bez
+ * vyhledávání, celkový čas je tedy O(n) místo O(n log n) pro count volání
+ * bst_insert. Funkce strom inicializuje, předchozí obsah stromu se
+ * neuvolní. Pokud se nepodaří alokovat některý uzel, vrátí false a strom
+ * zůstane prázdný.
+ */
+bool bst_build_sorted(bst_node_t **tree, const char keys[], const int values[],
+                      int count) {
+    return sorted_to_bst(0, count - 1, keys, values, tree);
+}
+
+/*
+ * Pomocná funkce která podle tabulky kořenů z bst_build_optimal vytvoří
+ * podstrom *tree s klíči keys[start..end-1]. Chyby jako u sorted_to_bst.
+ */
+static bool optimal_to_bst(int start, int end, const int roots[], int stride,
+                           const char keys[], const int weights[],
+                           bst_node_t **tree) {
+    *tree = NULL;
+    if (start >= end)
+        return true;
+
+    int mid = roots[start * stride + end];
+    bst_node_t *root = bst_node_alloc();
+    if (root == NULL)
+        return false;
+    root->key = keys[mid];
+    root->value = weights[mid];
+    root->left = NULL;
+    root->right = NULL;
+
+    if (!optimal_to_bst(start, mid, roots, stride, keys, weights,
+                        &root->left) ||
+        !optimal_to_bst(mid + 1, end, roots, stride, keys, weights,
+                        &root->right)) {
+        bst_dispose(&root);
+        return false;
+    }
+
+    BST_UPDATE_SIZE(root);
+    *tree = root;
+    return true;
+}
+
+/*
+ * Vytvoření stromu s nejmenším očekávaným počtem porovnání při
+ * vyhledávání, pokud se klíč keys[i] hledá s četností weights[i].
+ *
+ * Klíče musí být ostře rostoucí a četnosti nezáporné, např. klíče
+ * a hodnoty stromu z letter_count v pořadí inorder. Hodnotou uzlu je jeho
+ * četnost. Tabulka cen podstromů se počítá Knuthovým algoritmem: kořen
+ * optimálního podstromu leží mezi kořeny podstromů o jeden klíč kratších,
+ * takže celkový čas je O(n^2) a paměť O(n^2). Pokud se nepodaří alokovat
+ * tabulky, vytvoří se vyvážený strom jako v bst_build_sorted. Funkce strom
+ * inicializuje, předchozí obsah stromu se neuvolní. Pokud se nepodaří
+ * alokovat některý uzel, vrátí false a strom zůstane prázdný.
+ */
+bool bst_build_optimal(bst_node_t **tree, const char keys[],
+                       const int weights[], int count) {
+    *tree = NULL;
+    if (count <= 0)
+        return true;
+
+    // costs[i * stride + j] and roots[i * stride + j] describe the optimal
+    // subtree with keys[i..j-1], prefix[j] is the sum of weights[0..j-1].
+    int stride = count + 1;
+    size_t cells = (size_t)stride * stride;
+    int64_t *costs = malloc(cells * sizeof(int64_t));
+    int *roots = malloc(cells * sizeof(int));
+    int64_t *prefix = malloc(stride * sizeof(int64_t));
+    if (costs == NULL || roots == NULL || prefix == NULL) {
+        free(costs);
+        free(roots);
+        free(prefix);
+        return sorted_to_bst(0, count - 1, keys, weights, tree);
+    }
+
+    prefix[0] = 0;
+    for (int i = 0; i < count; i++) {
+        prefix[i + 1] = prefix[i] + weights[i];
+        costs[i * stride + i] = 0;
+        costs[i * stride + i + 1] = weights[i];
+        roots[i * stride + i + 1] = i;
+    }
+    costs[count * stride + count] = 0;
+
+    for (int length = 2; length <= count; length++) {
+        for (int start = 0; start + length <= count; start++) {
+            int end = start + length;
+            int first = roots[start * stride + end - 1];
+            int last = roots[(start + 1) * stride + end];
+            int64_t best = INT64_MAX;
+            int best_root = first;
+            for (int root = first; root <= last; root++) {
+                int64_t cost = costs[start * stride + root] +
+                               costs[(root + 1) * stride + end];
+                if (cost < best) {
+                    best = cost;
+                    best_root = root;
+                }
+            }
+            costs[start * stride + end] = best + prefix[end] - prefix[start];
+            roots[start * stride + end] = best_root;
+        }
+    }
+
+    bool built = optimal_to_bst(0, count, roots, stride, keys, weights, tree);
+    free(costs);
+    free(roots);
+    free(prefix);
+    return built;
 }
@@ -0,0 +1,105 @@
+/*
+ * Měření rychlosti vyhledávání ve stromu, dávkového vyhledávání
+ * (bst_i64_search_batch) a vyhledávání ve zmrazeném stromu.
+ *
+ * Použití: ./bench [maximální počet klíčů]
+ */
+#include "bst_gen.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_QUERIES 2000000
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+/*
+ * Vloží klíče 0, 2, 4, ... v pořadí, které vytvoří vyvážený strom
+ * (stejný tvar jako po bst_balance).
+ */
+static void bench_insert_balanced(bst_i64_node_t **tree, int64_t start,
+                                  int64_t end) {
+  if (start > end) {
+    return;
+  }
+  int64_t mid = start + (end - start) / 2;
+  bst_i64_insert(tree, 2 * mid, (int)mid);
+  bench_insert_balanced(tree, start, mid - 1);
+  bench_insert_balanced(tree, mid + 1, end);
+}
+
+static double bench_seconds(clock_t start) {
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+  long max_keys = argc > 1 ? atol(argv[1]) : 10000000;
+
+  int64_t *queries = malloc(BENCH_QUERIES * sizeof(int64_t));
+  int *values = malloc(BENCH_QUERIES * sizeof(int));
+  bool *found_batch = malloc(BENCH_QUERIES * sizeof(bool));
+  if (queries == NULL || values == NULL || found_batch == NULL) {
+    return 1;
+  }
+
+  printf("%10s %11s %11s %12s %8s %8s\n", "keys", "tree ns/op",
+         "batch ns/op", "frozen ns/op", "batch", "frozen");
+  for (long n = 10000; n <= max_keys; n *= 10) {
+    bst_i64_node_t *tree;
+    bst_i64_init(&tree);
+    bench_insert_balanced(&tree, 0, n - 1);
+
+    bst_i64_frozen_t frozen;
+    bst_i64_freeze(tree, &frozen);
+
+    // Half of the queries hit an even key, half miss on an odd one.
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+      queries[i] = (int64_t)(bench_random() % (uint64_t)(2 * n));
+    }
+
+    long found = 0;
+    int value;
+    clock_t start = clock();
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+      found += bst_i64_search(tree, queries[i], &value);
+    }
+    double tree_time = bench_seconds(start);
+
+    start = clock();
+    bst_i64_search_batch(tree, queries, BENCH_QUERIES, values, found_batch);
+    double batch_time = bench_seconds(start);
+    long batch_found = 0;
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+      batch_found += found_batch[i];
+    }
+
+    long frozen_found = 0;
+    start = clock();
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+      frozen_found += bst_i64_frozen_search(&frozen, queries[i], &value);
+    }
+    double frozen_time = bench_seconds(start);
+
+    if (found != frozen_found || found != batch_found) {
+      printf("[W] Search results mismatch\n");
+    }
+    printf("%10ld %11.1f %11.1f %12.1f %7.2fx %7.2fx\n", n,
+           tree_time * 1e9 / BENCH_QUERIES, batch_time * 1e9 / BENCH_QUERIES,
+           frozen_time * 1e9 / BENCH_QUERIES, tree_time / batch_time,
+           tree_time / frozen_time);
+
+    bst_i64_frozen_dispose(&frozen);
+    bst_i64_dispose(&tree);
+  }
+
+  free(queries);
+  free(values);
+  free(found_batch);
+  return 0;
+}
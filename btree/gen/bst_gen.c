@@ -0,0 +1,19 @@
+/*
+ * Implementace generických stromů deklarovaných v bst_gen.h.
+ */
+#include "bst_gen.h"
+
+BSTDEF(int64_t, int, bst_i64, BST_CMP_SCALAR)
+BSTDEF_ITEMS(bst_i64)
+BSTDEF_FROZEN(int64_t, int, bst_i64, BST_CMP_SCALAR)
+BSTDEF_BATCH(int64_t, int, bst_i64, BST_CMP_SCALAR)
+
+BSTDEF(const char *, int, bst_str, BST_CMP_STRING)
+BSTDEF_ITEMS(bst_str)
+BSTDEF_FROZEN(const char *, int, bst_str, BST_CMP_STRING)
+BSTDEF_BATCH(const char *, int, bst_str, BST_CMP_STRING)
+
+BSTDEF(uint32_t, int, bst_u32, BST_CMP_SCALAR)
+BSTDEF_ITEMS(bst_u32)
+BSTDEF_FROZEN(uint32_t, int, bst_u32, BST_CMP_SCALAR)
+BSTDEF_BATCH(uint32_t, int, bst_u32, BST_CMP_SCALAR)
@@ -0,0 +1,425 @@
+/*
+ * Hlavičkový soubor pro generický binární vyhledávací strom.
+ *
+ * Strom ze souboru btree.h má pevný klíč typu char a hodnotu typu int.
+ * Makra v tomto souboru generují stejné rozhraní pro libovolný typ klíče
+ * a hodnoty, podobně jako makra STACKDEC/STACKDEF v souboru iter/stack.h.
+ */
+#ifndef IAL_BTREE_GEN_BST_GEN_H
+#define IAL_BTREE_GEN_BST_GEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Porovnání klíčů. Výsledek je záporný, nulový nebo kladný podle toho, zda
+ * je první klíč menší, roven nebo větší než druhý. Jde o makra, takže se
+ * porovnání ve vygenerovaných funkcích rozvine přímo na místě použití.
+ */
+#define BST_CMP_SCALAR(A, B) (((A) > (B)) - ((A) < (B)))
+#define BST_CMP_STRING(A, B) strcmp((A), (B))
+
+/*
+ * Přednačtení paměti a počet jedniček na konci čísla pro vyhledávání ve
+ * zmrazeném stromu. Mimo GCC/Clang se přednačtení vynechá.
+ */
+#ifdef __GNUC__
+#define BST_PREFETCH(ADDR) __builtin_prefetch(ADDR)
+#define BST_TRAILING_ONES(X) __builtin_ctzll(~(unsigned long long)(X))
+#else
+#define BST_PREFETCH(ADDR) ((void)0)
+#define BST_TRAILING_ONES(X) bst_trailing_ones(X)
+static inline int bst_trailing_ones(size_t x) {
+  int count = 0;
+  while (x & 1) {
+    x >>= 1;
+    count++;
+  }
+  return count;
+}
+#endif
+
+// Velikost řádku cache v bajtech
+#define BST_CACHE_LINE 64
+// Počet současně rozpracovaných vyhledávání v NAME##_search_batch
+#define BST_BATCH 16
+
+/*
+ * Alokace a uvolnění uzlu ve vygenerovaných funkcích. Před vložením tohoto
+ * souboru je lze předefinovat, např. na pool uzlů z btree.h.
+ */
+#ifndef BST_GEN_ALLOC
+#define BST_GEN_ALLOC(SIZE) malloc(SIZE)
+#endif
+#ifndef BST_GEN_FREE
+#define BST_GEN_FREE(NODE) free(NODE)
+#endif
+
+/*
+ * Makro generující deklarace pro strom s klíčem typu K, hodnotou typu V
+ * a názvovým infixem NAME. Pro NAME="bst_i64", K="int64_t", V="int":
+ *   Datové typy bst_i64_node_t, bst_i64_items_t
+ *   Funkce void bst_i64_init(bst_i64_node_t **tree)
+ *           void bst_i64_insert(bst_i64_node_t **tree, int64_t key, int value)
+ *           bool bst_i64_search(bst_i64_node_t *tree, int64_t key, int *value)
+ *           void bst_i64_delete(bst_i64_node_t **tree, int64_t key)
+ *           void bst_i64_dispose(bst_i64_node_t **tree)
+ *   a dále průchody, bst_i64_range, bst_i64_count_range a zmrazený strom
+ *   bst_i64_frozen_t se stejným významem jako v btree.h. Parametr CMP je
+ *   zde jen kvůli symetrii s BSTDEF.
+ *
+ * Strom s klíčem char a hodnotou int z btree.h odpovídá přesně
+ * BSTDEC(char, int, bst, BST_CMP_SCALAR).
+ */
+#define BSTDEC(K, V, NAME, CMP)                                                \
+  typedef struct NAME##_node {                                                 \
+    K key;                                                                     \
+    V value;                                                                   \
+    struct NAME##_node *left;                                                  \
+    struct NAME##_node *right;                                                 \
+  } NAME##_node_t;                                                             \
+                                                                               \
+  typedef struct NAME##_items {                                                \
+    NAME##_node_t **nodes;                                                     \
+    int capacity;                                                              \
+    int size;                                                                  \
+  } NAME##_items_t;                                                            \
+                                                                               \
+  typedef struct NAME##_frozen {                                               \
+    K *keys;                                                                   \
+    V *values;                                                                 \
+    int size;                                                                  \
+  } NAME##_frozen_t;                                                           \
+                                                                               \
+  void NAME##_init(NAME##_node_t **tree);                                      \
+  void NAME##_insert(NAME##_node_t **tree, K key, V value);                    \
+  bool NAME##_search(NAME##_node_t *tree, K key, V *value);                    \
+  void NAME##_delete(NAME##_node_t **tree, K key);                             \
+  void NAME##_dispose(NAME##_node_t **tree);                                   \
+  void NAME##_add_node_to_items(NAME##_node_t *node, NAME##_items_t *items);   \
+  void NAME##_preorder(NAME##_node_t *tree, NAME##_items_t *items);            \
+  void NAME##_inorder(NAME##_node_t *tree, NAME##_items_t *items);             \
+  void NAME##_postorder(NAME##_node_t *tree, NAME##_items_t *items);           \
+  void NAME##_range(NAME##_node_t *tree, K lo, K hi, NAME##_items_t *items);   \
+  int NAME##_count_range(NAME##_node_t *tree, K lo, K hi);                     \
+  void NAME##_replace_by_rightmost(NAME##_node_t *target,                      \
+                                   NAME##_node_t **tree);                      \
+  void NAME##_freeze(NAME##_node_t *tree, NAME##_frozen_t *frozen);            \
+  bool NAME##_frozen_search(NAME##_frozen_t *frozen, K key, V *value);         \
+  void NAME##_frozen_dispose(NAME##_frozen_t *frozen);                         \
+  void NAME##_search_batch(NAME##_node_t *tree, const K keys[], int n,         \
+                           V values[], bool found[]);
+
+/*
+ * Makro generující implementaci funkcí deklarovaných makrem BSTDEC.
+ *
+ * Vyhledání, vložení i odstranění jsou iterativní, zrušení stromu
+ * narovnává strom rotacemi a nepotřebuje zásobník. Průchody jsou
+ * rekurzivní jako v rec/btree.c. Funkce NAME##_add_node_to_items
+ * generuje samostatné makro BSTDEF_ITEMS, protože pro strom z btree.h
+ * ji už poskytuje btree.c. Automatické vyvažování (BST_SCAPEGOAT)
+ * vygenerované stromy nepodporují, strom z btree.h ho spolu s BST_SPLAY
+ * doplňuje v gen/btree.c.
+ */
+#define BSTDEF(K, V, NAME, CMP)                                                \
+  void NAME##_init(NAME##_node_t **tree) { (*tree) = NULL; }                   \
+                                                                               \
+  bool NAME##_search(NAME##_node_t *tree, K key, V *value) {                   \
+    while (tree != NULL) {                                                     \
+      int cmp = CMP(key, tree->key);                                           \
+      if (cmp == 0) {                                                          \
+        *value = tree->value;                                                  \
+        return true;                                                           \
+      }                                                                        \
+      tree = cmp < 0 ? tree->left : tree->right;                               \
+    }                                                                          \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  void NAME##_insert(NAME##_node_t **tree, K key, V value) {                   \
+    while ((*tree) != NULL) {                                                  \
+      int cmp = CMP(key, (*tree)->key);                                        \
+      if (cmp == 0) {                                                          \
+        (*tree)->value = value;                                                \
+        return;                                                                \
+      }                                                                        \
+      tree = cmp < 0 ? &((*tree)->left) : &((*tree)->right);                   \
+    }                                                                          \
+    NAME##_node_t *insert_node = BST_GEN_ALLOC(sizeof(NAME##_node_t));         \
+    if (insert_node == NULL) {                                                 \
+      return;                                                                  \
+    }                                                                          \
+    insert_node->key = key;                                                    \
+    insert_node->value = value;                                                \
+    insert_node->left = NULL;                                                  \
+    insert_node->right = NULL;                                                 \
+    (*tree) = insert_node;                                                     \
+  }                                                                            \
+                                                                               \
+  void NAME##_replace_by_rightmost(NAME##_node_t *target,                      \
+                                   NAME##_node_t **tree) {                     \
+    while ((*tree)->right != NULL) {                                           \
+      tree = &((*tree)->right);                                                \
+    }                                                                          \
+    target->key = (*tree)->key;                                                \
+    target->value = (*tree)->value;                                            \
+    NAME##_node_t *delete_node = (*tree);                                      \
+    (*tree) = (*tree)->left;                                                   \
+    BST_GEN_FREE(delete_node);                                                 \
+  }                                                                            \
+                                                                               \
+  void NAME##_delete(NAME##_node_t **tree, K key) {                            \
+    while ((*tree) != NULL) {                                                  \
+      int cmp = CMP(key, (*tree)->key);                                        \
+      if (cmp == 0) {                                                          \
+        break;                                                                 \
+      }                                                                        \
+      tree = cmp < 0 ? &((*tree)->left) : &((*tree)->right);                   \
+    }                                                                          \
+    if ((*tree) == NULL) {                                                     \
+      return;                                                                  \
+    }                                                                          \
+    if ((*tree)->left != NULL && (*tree)->right != NULL) {                     \
+      NAME##_replace_by_rightmost((*tree), &((*tree)->left));                  \
+    } else {                                                                   \
+      NAME##_node_t *delete_node = (*tree);                                    \
+      (*tree) = (*tree)->left != NULL ? (*tree)->left : (*tree)->right;        \
+      BST_GEN_FREE(delete_node);                                               \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  void NAME##_dispose(NAME##_node_t **tree) {                                  \
+    NAME##_node_t *node = (*tree);                                             \
+    while (node != NULL) {                                                     \
+      if (node->left != NULL) {                                                \
+        /* Rotate right, so the left subtree gets freed later. */              \
+        NAME##_node_t *left = node->left;                                      \
+        node->left = left->right;                                              \
+        left->right = node;                                                    \
+        node = left;                                                           \
+      } else {                                                                 \
+        NAME##_node_t *right = node->right;                                    \
+        BST_GEN_FREE(node);                                                    \
+        node = right;                                                          \
+      }                                                                        \
+    }                                                                          \
+    (*tree) = NULL;                                                            \
+  }                                                                            \
+                                                                               \
+  void NAME##_preorder(NAME##_node_t *tree, NAME##_items_t *items) {           \
+    if (tree == NULL) {                                                        \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_add_node_to_items(tree, items);                                     \
+    NAME##_preorder(tree->left, items);                                        \
+    NAME##_preorder(tree->right, items);                                       \
+  }                                                                            \
+                                                                               \
+  void NAME##_inorder(NAME##_node_t *tree, NAME##_items_t *items) {            \
+    if (tree == NULL) {                                                        \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_inorder(tree->left, items);                                         \
+    NAME##_add_node_to_items(tree, items);                                     \
+    NAME##_inorder(tree->right, items);                                        \
+  }                                                                            \
+                                                                               \
+  void NAME##_postorder(NAME##_node_t *tree, NAME##_items_t *items) {          \
+    if (tree == NULL) {                                                        \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_postorder(tree->left, items);                                       \
+    NAME##_postorder(tree->right, items);                                      \
+    NAME##_add_node_to_items(tree, items);                                     \
+  }                                                                            \
+                                                                               \
+  void NAME##_range(NAME##_node_t *tree, K lo, K hi, NAME##_items_t *items) {  \
+    if (tree == NULL) {                                                        \
+      return;                                                                  \
+    }                                                                          \
+    bool above_lo = CMP(lo, tree->key) <= 0;                                   \
+    bool below_hi = CMP(tree->key, hi) <= 0;                                   \
+    if (above_lo) {                                                            \
+      NAME##_range(tree->left, lo, hi, items);                                 \
+    }                                                                          \
+    if (above_lo && below_hi) {                                                \
+      NAME##_add_node_to_items(tree, items);                                   \
+    }                                                                          \
+    if (below_hi) {                                                            \
+      NAME##_range(tree->right, lo, hi, items);                                \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  int NAME##_count_range(NAME##_node_t *tree, K lo, K hi) {                    \
+    if (tree == NULL) {                                                        \
+      return 0;                                                                \
+    }                                                                          \
+    bool above_lo = CMP(lo, tree->key) <= 0;                                   \
+    bool below_hi = CMP(tree->key, hi) <= 0;                                   \
+    int count = (above_lo && below_hi) ? 1 : 0;                                \
+    if (above_lo) {                                                            \
+      count += NAME##_count_range(tree->left, lo, hi);                         \
+    }                                                                          \
+    if (below_hi) {                                                            \
+      count += NAME##_count_range(tree->right, lo, hi);                        \
+    }                                                                          \
+    return count;                                                              \
+  }
+
+/*
+ * Makro generující funkce pro zmrazený strom, viz bst_freeze v btree.c.
+ *
+ * Zmrazený strom je úplný binární strom uložený v poli v pořadí Eytzinger
+ * (kořen na indexu 1, potomci uzlu k na indexech 2k a 2k+1). Vyhledávání
+ * nepotřebuje ukazatele ani podmíněné skoky podle výsledku porovnání
+ * a přednačítá uzly o několik úrovní níže: potomci uzlu k o log2(B)
+ * úrovní níže leží vedle sebe na jednom řádku cache od indexu k*B.
+ */
+#define BSTDEF_FROZEN(K, V, NAME, CMP)                                         \
+  void NAME##_freeze(NAME##_node_t *tree, NAME##_frozen_t *frozen) {           \
+    NAME##_items_t items = {NULL, 0, 0};                                       \
+    NAME##_inorder(tree, &items);                                              \
+                                                                               \
+    frozen->size = items.size;                                                 \
+    frozen->keys = malloc((items.size + 1) * sizeof(K));                       \
+    frozen->values = malloc((items.size + 1) * sizeof(V));                     \
+    if (frozen->keys == NULL || frozen->values == NULL) {                      \
+      NAME##_frozen_dispose(frozen);                                           \
+      free(items.nodes);                                                       \
+      return;                                                                  \
+    }                                                                          \
+                                                                               \
+    /* Walk the implicit complete tree inorder from its leftmost node. */      \
+    size_t n = items.size;                                                     \
+    size_t k = 1;                                                              \
+    while (2 * k <= n) {                                                       \
+      k = 2 * k;                                                               \
+    }                                                                          \
+    for (int i = 0; i < items.size; i++) {                                     \
+      frozen->keys[k] = items.nodes[i]->key;                                   \
+      frozen->values[k] = items.nodes[i]->value;                               \
+      if (2 * k + 1 <= n) {                                                    \
+        k = 2 * k + 1;                                                         \
+        while (2 * k <= n) {                                                   \
+          k = 2 * k;                                                           \
+        }                                                                      \
+      } else {                                                                 \
+        k >>= BST_TRAILING_ONES(k) + 1;                                        \
+      }                                                                        \
+    }                                                                          \
+    free(items.nodes);                                                         \
+  }                                                                            \
+                                                                               \
+  bool NAME##_frozen_search(NAME##_frozen_t *frozen, K key, V *value) {        \
+    const size_t stride =                                                      \
+        sizeof(K) < BST_CACHE_LINE ? BST_CACHE_LINE / sizeof(K) : 1;           \
+    size_t n = frozen->size;                                                   \
+    size_t k = 1;                                                              \
+    while (k <= n) {                                                           \
+      BST_PREFETCH((const void *)((uintptr_t)frozen->keys +                    \
+                                  k * stride * sizeof(K)));                    \
+      k = 2 * k + (CMP(frozen->keys[k], key) < 0);                             \
+    }                                                                          \
+    /* Undo the right turns after the last left turn, which was at the */      \
+    /* smallest key not less than the searched one. */                         \
+    k >>= BST_TRAILING_ONES(k) + 1;                                            \
+    if (k != 0 && CMP(frozen->keys[k], key) == 0) {                            \
+      *value = frozen->values[k];                                              \
+      return true;                                                             \
+    }                                                                          \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  void NAME##_frozen_dispose(NAME##_frozen_t *frozen) {                        \
+    free(frozen->keys);                                                        \
+    free(frozen->values);                                                      \
+    frozen->keys = NULL;                                                       \
+    frozen->values = NULL;                                                     \
+    frozen->size = 0;                                                          \
+  }
+
+/*
+ * Makro generující dávkové vyhledávání NAME##_search_batch.
+ *
+ * Každý krok vyhledávání čeká na načtení uzlu z paměti, který závisí na
+ * předchozím kroku. Funkce proto posouvá BST_BATCH vyhledávání najednou
+ * o jednu úroveň stromu a další uzel každého z nich přednačte. Než se
+ * k vyhledávání vrátí, uzel už je v cache a výpadky cache jednotlivých
+ * vyhledávání se překrývají. Místo dokončeného vyhledávání hned začne
+ * další, takže na nejhlubší vyhledávání skupiny nikdo nečeká.
+ *
+ * Výsledek je stejný jako n volání NAME##_search: found[i] říká, zda byl
+ * klíč keys[i] nalezen, a values[i] se změní jen pro nalezené klíče.
+ */
+#define BSTDEF_BATCH(K, V, NAME, CMP)                                          \
+  void NAME##_search_batch(NAME##_node_t *tree, const K keys[], int n,         \
+                           V values[], bool found[]) {                         \
+    NAME##_node_t *current[BST_BATCH]; /* node each search visits next */      \
+    int index[BST_BATCH];              /* position in keys of each search */   \
+    int active = 0;                                                            \
+    int next = 0;                                                              \
+    for (; active < BST_BATCH && next < n; active++, next++) {                 \
+      current[active] = tree;                                                  \
+      index[active] = next;                                                    \
+    }                                                                          \
+                                                                               \
+    while (active > 0) {                                                       \
+      for (int i = 0; i < active; i++) {                                       \
+        NAME##_node_t *node = current[i];                                      \
+        int position = index[i];                                               \
+        int cmp = node != NULL ? CMP(keys[position], node->key) : 0;           \
+        if (cmp != 0) {                                                        \
+          node = cmp < 0 ? node->left : node->right;                           \
+          if (node != NULL) {                                                  \
+            BST_PREFETCH(node);                                                \
+          }                                                                    \
+          current[i] = node;                                                   \
+          continue;                                                            \
+        }                                                                      \
+                                                                               \
+        found[position] = node != NULL;                                        \
+        if (node != NULL) {                                                    \
+          values[position] = node->value;                                      \
+        }                                                                      \
+        /* The slot continues with the next key, or the last search */         \
+        /* moves into it. */                                                   \
+        if (next < n) {                                                        \
+          current[i] = tree;                                                   \
+          index[i] = next++;                                                   \
+        } else {                                                               \
+          active--;                                                            \
+          current[i] = current[active];                                        \
+          index[i] = index[active];                                            \
+          i--;                                                                 \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+  }
+
+/*
+ * Makro generující funkci NAME##_add_node_to_items, viz btree.c.
+ */
+#define BSTDEF_ITEMS(NAME)                                                     \
+  void NAME##_add_node_to_items(NAME##_node_t *node, NAME##_items_t *items) {  \
+    if (items->capacity < items->size + 1) {                                   \
+      items->capacity = items->capacity * 2 + 8;                               \
+      items->nodes =                                                           \
+          realloc(items->nodes, items->capacity * sizeof(NAME##_node_t *));    \
+    }                                                                          \
+    items->nodes[items->size] = node;                                          \
+    items->size++;                                                             \
+  }
+
+// Strom s celočíselnými 64bitovými klíči (např. identifikátory)
+BSTDEC(int64_t, int, bst_i64, BST_CMP_SCALAR)
+
+// Strom s řetězcovými klíči, klíče se nekopírují (jako v hashtable.c)
+BSTDEC(const char *, int, bst_str, BST_CMP_STRING)
+
+// Strom s klíči typu uint32_t (např. kódové body Unicode v letter_count_utf8)
+BSTDEC(uint32_t, int, bst_u32, BST_CMP_SCALAR)
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Binární vyhledávací strom — generická varianta
+ *
+ * Strom s klíčem typu char a hodnotou typu int ze souboru btree.h
+ * vygenerovaný makrem BSTDEF ze souboru bst_gen.h. Vyhledání, vložení,
+ * odstranění a zrušení navíc podporují režimy BST_SPLAY a BST_SCAPEGOAT
+ * stejně jako rec/iter varianta. Režimy při překladu (BST_ORDER_STATISTICS,
+ * BST_PERSISTENT a BST_STATS) BSTDEF nepodporuje a překlad s nimi selže.
+ */
+
+#include "../btree.h"
+
+#if defined(BST_ORDER_STATISTICS) || defined(BST_PERSISTENT) ||              \
+    defined(BST_STATS)
+#error "BSTDEF supports neither BST_ORDER_STATISTICS, BST_PERSISTENT nor BST_STATS"
+#endif
+
+// Uzly se alokují stejně jako v rec/iter variantě, tedy i z BST_POOL.
+#define BST_GEN_ALLOC(SIZE) bst_node_alloc()
+#define BST_GEN_FREE(NODE) bst_node_free(NODE)
+
+#include "bst_gen.h"
+
+// BSTDEF generates these four under the bst_gen prefix, the functions of
+// btree.h below add the runtime modes on top of them.
+#define bst_search bst_gen_search
+#define bst_insert bst_gen_insert
+#define bst_delete bst_gen_delete
+#define bst_dispose bst_gen_dispose
+
+BSTDEF(char, int, bst, BST_CMP_SCALAR)
+
+#undef bst_search
+#undef bst_insert
+#undef bst_delete
+#undef bst_dispose
+
+/*
+ * Vyhledání uzlu ve stromu, viz bst_search v rec/btree.c.
+ *
+ * V režimu BST_SPLAY se nalezený uzel přesune do kořene (viz bst_splay).
+ */
+bool bst_search(bst_node_t *tree, char key, int *value) {
+  if (BST_SPLAY && tree != NULL) {
+    // After splaying, the key is either in the root or missing.
+    bst_splay(tree, key);
+  }
+  return bst_gen_search(tree, key, value);
+}
+
+/*
+ * Vložení uzlu do stromu, viz bst_insert v iter/btree.c.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a nový uzel
+ * leží příliš hluboko, přestaví se obětní beránek na cestě ke kořeni.
+ * V režimu BST_SPLAY se nový uzel stane kořenem (viz bst_splay_insert).
+ */
+void bst_insert(bst_node_t **tree, char key, int value) {
+  if (BST_SPLAY) {
+    bst_splay_insert(tree, key, value);
+    return;
+  }
+  bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
+  if (scapegoat == NULL) {
+    bst_gen_insert(tree, key, value);
+    return;
+  }
+
+  // Links to the ancestors of the new node, keys are char so at most 256.
+  bst_node_t **links[256];
+  int depth = 0;
+  bst_node_t **link = tree;
+  while ((*link) != NULL) {
+    if ((*link)->key == key) {
+      (*link)->value = value;
+      return;
+    }
+    links[depth++] = link;
+    link = key < (*link)->key ? &((*link)->left) : &((*link)->right);
+  }
+  bst_gen_insert(link, key, value);
+  if ((*link) == NULL) { // Allocation failed.
+    return;
+  }
+
+  scapegoat->size++;
+  if (scapegoat->size > scapegoat->max_size) {
+    scapegoat->max_size = scapegoat->size;
+  }
+  if (bst_scapegoat_too_deep(depth, scapegoat->size)) {
+    scapegoat->subtree_size = 1;
+    for (int i = depth - 1; i >= 0 && scapegoat->subtree_size > 0; i--) {
+      bst_scapegoat_climb(links[i], key < (*links[i])->key);
+    }
+    scapegoat->subtree_size = 0;
+  }
+}
+
+/*
+ * Odstranění uzlu ze stromu, viz bst_delete v iter/btree.c.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a počet
+ * uzlů klesne pod 2/3 největšího dosaženého počtu, přestaví se celý strom.
+ * V režimu BST_SPLAY se místo toho použije bst_splay_delete.
+ */
+void bst_delete(bst_node_t **tree, char key) {
+  if (BST_SPLAY) {
+    bst_splay_delete(tree, key);
+    return;
+  }
+  bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
+  int value;
+  bool found = scapegoat != NULL && bst_gen_search(*tree, key, &value);
+  bst_gen_delete(tree, key);
+  if (!found) {
+    return;
+  }
+
+  scapegoat->size--;
+  if (scapegoat->size * 3 < scapegoat->max_size * 2) {
+    bst_rebuild(tree, scapegoat->size);
+    scapegoat->max_size = scapegoat->size;
+  }
+}
+
+/*
+ * Zrušení celého stromu. Stav BST_SCAPEGOAT se vynuluje, jen pokud patří
+ * rušenému stromu.
+ */
+void bst_dispose(bst_node_t **tree) {
+  bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
+  if (scapegoat != NULL && (*tree) != NULL) {
+    scapegoat->size = 0;
+    scapegoat->max_size = 0;
+  }
+  bst_gen_dispose(tree);
+}
@@ -31,22 +31,39 @@ void bst_init(bst_node_t **tree) {
  * value zůstává nezměněná.
  * 
  * Funkci implementujte iterativně bez použité vlastních pomocných funkcí.
+ *
+ * V režimu BST_SPLAY se nalezený uzel přesune do kořene (viz bst_splay).
  */
 bool bst_search(bst_node_t *tree, char key, int *value) {
+	BST_STATS_ENTER(BST_STATS_SEARCH);
 
 	if (tree == NULL){
+		BST_STATS_LEAVE();
 		return false;
 	}
 
+#ifndef BST_PERSISTENT
+	if (BST_SPLAY){
+		// After splaying, the key is either in the root or missing.
+		bst_splay(tree, key);
+		if (tree->key != key){
+			BST_STATS_LEAVE();
+			return false;
+		}
+	}
+#endif
+
 	bst_node_t *current_node = tree; 
 
 	while (current_node != NULL){
-		if (current_node->key == key){
+		BST_STATS_HOP();
+		if (BST_STATS_CMP(current_node->key == key)){
 			// Succses. Current node is the node we looking for.
 			*value = current_node->value; // Store the note value to '*value' pointer.
+			BST_STATS_LEAVE();
 			return true;
 
-		} else if (current_node->key < key){ 	// If looking key is greater than current,
+		} else if (BST_STATS_CMP(current_node->key < key)){ 	// If looking key is greater than current,
 			current_node = current_node->right;	// go to the right branch.
 
 		} else {
@@ -54,9 +71,45 @@ bool bst_search(bst_node_t *tree, char key, int *value) {
 		}		
 	}
 
+	BST_STATS_LEAVE();
 	return false;
 }
 
+/*
+ * Pomocná funkce pro automatické vyvažování.
+ *
+ * Uzel s klíčem key v hloubce depth je příliš hluboko. Funkce projde
+ * předky uzlu od nejnižšího a první z nich, jehož potomek na cestě obsahuje
+ * více než 2/3 uzlů jeho podstromu (obětního beránka), přestaví.
+ *
+ * Odkazy na předky se ukládají do pole o MAXSTACK prvcích, strom s klíči
+ * typu char má nejvýše 256 úrovní. Hlubší strom se nepřestaví a zůstane
+ * beze změny.
+ */
+static void bst_rebuild_scapegoat(bst_node_t **tree, char key, int depth) {
+	// Links to the ancestors of the new node, from the root down.
+	bst_node_t **links[MAXSTACK];
+	if (depth > MAXSTACK){
+		return;
+	}
+
+	bst_node_t **current_node = tree;
+	for (int i = 0; i < depth; i++){
+		links[i] = current_node;
+		if ((*current_node)->key < key){
+			current_node = &((*current_node)->right);
+		} else {
+			current_node = &((*current_node)->left);
+		}
+	}
+
+	BST_SCAPEGOAT->subtree_size = 1;
+	for (int i = depth - 1; i >= 0 && BST_SCAPEGOAT->subtree_size > 0; i--){
+		bst_scapegoat_climb(links[i], key < (*links[i])->key);
+	}
+	BST_SCAPEGOAT->subtree_size = 0;
+}
+
 /*
  * Vložení uzlu do stromu.
  *
@@ -67,36 +120,48 @@ bool bst_search(bst_node_t *tree, char key, int *value) {
  * uzlu obsahuje jenom menší klíče, pravý větší. 
  *
  * Funkci implementujte iterativně bez použití vlastních pomocných funkcí.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a nový uzel
+ * leží hlouběji než log_{3/2}(počet uzlů), přestaví se nejmenší nevyvážený
+ * podstrom na jeho cestě ke kořeni (obětní beránek). Amortizovaná cena
+ * vložení je pak O(log n) bez dalších údajů v uzlech.
+ *
+ * V režimu BST_SPLAY se nový uzel stane kořenem (viz bst_splay_insert).
  */
 void bst_insert(bst_node_t **tree, char key, int value) {
-    // if (*tree == NULL) {
-    //     return;
-    // }
-
-	if (*tree == NULL) {
-        *tree = (bst_node_t *)malloc(sizeof(bst_node_t));
-        if (*tree == NULL) {
-            return;
-        }
-        (*tree)->key = key;
-        (*tree)->value = value;
-        (*tree)->left = NULL;
-        (*tree)->right = NULL;
-        return;
-    }
+#ifdef BST_PERSISTENT
+	// Path copying, *tree becomes the new version (see btree.h).
+	bst_node_t *version;
+	if (bst_persistent_insert(*tree, key, value, &version)){
+		bst_persistent_release(*tree);
+		*tree = version;
+	}
+	return;
+#endif
+	BST_STATS_ENTER(BST_STATS_INSERT);
+	if (BST_SPLAY){
+		bst_splay_insert(tree, key, value);
+		BST_STATS_LEAVE();
+		return;
+	}
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
 
+	// An empty tree is handled by the loop below, the new node becomes the root.
 	bool node_found = false;
 	bst_node_t **current_node = tree;
+	int depth = 0; // Depth of the '*current_node' slot.
 
 	while ((*current_node) != NULL)
 	{
-		if ((*current_node)->key == key) // Node with the same key is already exist.
+		depth++;
+		BST_STATS_HOP();
+		if (BST_STATS_CMP((*current_node)->key == key)) // Node with the same key is already exist.
 		{
 			(*current_node)->value = value; // Set new value to the Node.
 			node_found = true;
 			break;
 
-		} else if ((*current_node)->key < key)
+		} else if (BST_STATS_CMP((*current_node)->key < key))
 		{
 			current_node = &((*current_node)->right);
 		} else
@@ -116,9 +181,10 @@ void bst_insert(bst_node_t **tree, char key, int value) {
 			  NUll  NULL
 		*/
 
-		bst_node_t *insert_node = (bst_node_t *) malloc(sizeof(bst_node_t));
+		bst_node_t *insert_node = bst_node_alloc();
 		if (insert_node == NULL){
 			//return 1;
+			BST_STATS_LEAVE();
 			return;
 		}
 
@@ -126,10 +192,29 @@ void bst_insert(bst_node_t **tree, char key, int value) {
 		insert_node->value = value;
 		insert_node->left = NULL;
 		insert_node->right = NULL;
+		BST_UPDATE_SIZE(insert_node);
 		// After while loop (*current_node) == NULL
 		(*current_node) = insert_node; // Set current node pointer to the new leaf.
-		
+
+#ifdef BST_ORDER_STATISTICS
+		// Every ancestor of the new leaf has gained one node.
+		for (bst_node_t *node = *tree; node != insert_node;
+		     node = node->key < key ? node->right : node->left){
+			node->size++;
+		}
+#endif
+
+		if (scapegoat != NULL){
+			scapegoat->size++;
+			if (scapegoat->size > scapegoat->max_size){
+				scapegoat->max_size = scapegoat->size;
+			}
+			if (bst_scapegoat_too_deep(depth, scapegoat->size)){
+				bst_rebuild_scapegoat(tree, key, depth);
+			}
+		}
 	}
+	BST_STATS_LEAVE();
 	return;
 }
 
@@ -150,8 +235,11 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
 	
 	bst_node_t **rightmost_node = tree;
 	while ((*rightmost_node)->right != NULL){
+		BST_STATS_HOP();
+		BST_ADD_SIZE(*rightmost_node, -1); // Loses the rightmost node.
 		rightmost_node = &((*rightmost_node)->right);
 	}
+	BST_STATS_HOP();
 	// Store the rightmost node values to target node.
 	target->key = (*rightmost_node)->key;
 	target->value = (*rightmost_node)->value;
@@ -159,7 +247,7 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
 	// Save the rightmost node address to delete_node pointer.
 	bst_node_t *delete_node = *rightmost_node;
 	*rightmost_node = (*rightmost_node)->left;
-	free(delete_node);
+	bst_node_free(delete_node);
 }
 
 /*
@@ -174,12 +262,34 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
  * 
  * Funkci implementujte iterativně pomocí bst_replace_by_rightmost a bez
  * použití vlastních pomocných funkcí.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a počet
+ * uzlů klesne pod 2/3 největšího dosaženého počtu, přestaví se celý strom.
+ *
+ * V režimu BST_SPLAY se místo toho použije bst_splay_delete.
  */
 void bst_delete(bst_node_t **tree, char key) {
 	if (tree == NULL) { // Pointer to the tree is empty.
         return;
     }
+#ifdef BST_PERSISTENT
+	// Path copying, *tree becomes the new version (see btree.h).
+	bst_node_t *version;
+	if (bst_persistent_delete(*tree, key, &version)){
+		bst_persistent_release(*tree);
+		*tree = version;
+	}
+	return;
+#endif
+	BST_STATS_ENTER(BST_STATS_DELETE);
+	if (BST_SPLAY){
+		bst_splay_delete(tree, key);
+		BST_STATS_LEAVE();
+		return;
+	}
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
     if ((*tree) == NULL) { // Tree is empty.
+		BST_STATS_LEAVE();
         return;
     }
 
@@ -187,9 +297,10 @@ void bst_delete(bst_node_t **tree, char key) {
 	
 	// Looking for the node with the same key we want to delete.
 	while ((*current_node) != NULL){
-		if ((*current_node)->key == key){
+		BST_STATS_HOP();
+		if (BST_STATS_CMP((*current_node)->key == key)){
 			break;
-		} else if ((*current_node)->key < key){
+		} else if (BST_STATS_CMP((*current_node)->key < key)){
 			current_node = &((*current_node)->right);
 		} else {
 			current_node = &((*current_node)->left);
@@ -197,13 +308,27 @@ void bst_delete(bst_node_t **tree, char key) {
 	}
 
 	if ((*current_node) == NULL){ // Node with the same key was not found.
+		BST_STATS_LEAVE();
 		return; // Nothing to delete.
 	}
 
+	if (scapegoat != NULL){
+		scapegoat->size--;
+	}
+
+#ifdef BST_ORDER_STATISTICS
+	// Every node on the path, the found node included, loses one node.
+	for (bst_node_t *node = *tree; node != (*current_node);
+	     node = node->key < key ? node->right : node->left){
+		node->size--;
+	}
+	(*current_node)->size--;
+#endif
+
 	// Or the 'current_node' has the same key, that we want to delete.
 	// First check if the node is leaf (has no children).
 	if ((*current_node)->left == NULL && (*current_node)->right == NULL){
-		free((*current_node));
+		bst_node_free((*current_node));
 		(*current_node) = NULL;
 
 	// If the node has both children, replace it by the rightmost node of the left subtree.
@@ -214,14 +339,21 @@ void bst_delete(bst_node_t **tree, char key) {
 	} else if ((*current_node)->left == NULL){
 		bst_node_t *delete_node = *current_node;
 		(*current_node) = (*current_node)->right;
-		free(delete_node);
+		bst_node_free(delete_node);
 
 	// If the node has only one (left) child, replace it by the child.
 	} else {
 		bst_node_t *delete_node = *current_node;
 		(*current_node) = (*current_node)->left;
-		free(delete_node);
+		bst_node_free(delete_node);
+	}
+
+	// Rebuild the whole tree once it has shrunk below 2/3 of its largest size.
+	if (scapegoat != NULL && scapegoat->size * 3 < scapegoat->max_size * 2){
+		bst_rebuild(tree, scapegoat->size);
+		scapegoat->max_size = scapegoat->size;
 	}
+	BST_STATS_LEAVE();
 }
 
 /*
@@ -241,6 +373,17 @@ void bst_dispose(bst_node_t **tree) {
 	if ((*tree) == NULL) {
 		return;
 	}
+#ifdef BST_PERSISTENT
+	// Other versions may share the nodes, only this reference is dropped.
+	bst_persistent_release(*tree);
+	*tree = NULL;
+	return;
+#endif
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
+	if (scapegoat != NULL) {
+		scapegoat->size = 0;
+		scapegoat->max_size = 0;
+	}
 
 	stack_bst_t stack; // Stack of nodes.
 	stack_bst_init(&stack);
@@ -255,7 +398,7 @@ void bst_dispose(bst_node_t **tree) {
 			bst_node_t *delete_node = (*tree);
 			// Go to the left branch.
 			(*tree) = (*tree)->left;
-			free(delete_node);
+			bst_node_free(delete_node);
 		// If the current node is NULL and the stack is not empty, pop the node from the stack.
 		} else {
 			if (!stack_bst_empty(&stack)){
@@ -440,3 +583,126 @@ void bst_postorder(bst_node_t *tree, bst_items_t *items) {
 		}
 	}
 }
+
+/*
+ * Pomocná funkce pro iterativní průchod intervalem.
+ *
+ * Prochází po levé větvi k nejlevějšímu uzlu podstromu s klíčem větším nebo
+ * rovným lo a ukládá uzly do zásobníku uzlů. Uzly s menším klíčem (i s jejich
+ * levými podstromy) přeskočí.
+ */
+static void bst_leftmost_range(bst_node_t *tree, char lo, stack_bst_t *to_visit) {
+	while (tree != NULL){
+		if (tree->key < lo){
+			// The node and its whole left subtree are below the range.
+			tree = tree->right;
+		} else {
+			stack_bst_push(to_visit, tree);
+			tree = tree->left;
+		}
+	}
+}
+
+/*
+ * Průchod uzly s klíči z intervalu <lo,hi>.
+ *
+ * Pro každý uzel s klíčem z intervalu zavolejte (ve vzestupném pořadí klíčů)
+ * funkci bst_add_node_to_items. Do podstromů, které nemohou obsahovat klíč
+ * z intervalu, funkce nesestupuje, cena je tedy O(výška + počet nalezených).
+ *
+ * Funkci implementujte iterativně pomocí funkce bst_leftmost_range a
+ * zásobníku uzlů.
+ */
+void bst_range(bst_node_t *tree, char lo, char hi, bst_items_t *items) {
+	stack_bst_t stack; // Stack of nodes.
+	stack_bst_init(&stack);
+
+	bst_leftmost_range(tree, lo, &stack);
+
+	while (!stack_bst_empty(&stack))
+	{
+		tree = stack_bst_pop(&stack);
+		if (tree->key > hi){ // Every remaining node is above the range.
+			break;
+		}
+		bst_add_node_to_items(tree, items);
+		bst_leftmost_range(tree->right, lo, &stack);
+	}
+}
+
+/*
+ * Počet uzlů s klíči z intervalu <lo,hi>.
+ *
+ * Funkci implementujte iterativně pomocí funkce bst_leftmost_range a
+ * zásobníku uzlů.
+ */
+int bst_count_range(bst_node_t *tree, char lo, char hi) {
+	int count = 0;
+
+	stack_bst_t stack; // Stack of nodes.
+	stack_bst_init(&stack);
+
+	bst_leftmost_range(tree, lo, &stack);
+
+	while (!stack_bst_empty(&stack))
+	{
+		tree = stack_bst_pop(&stack);
+		if (tree->key > hi){ // Every remaining node is above the range.
+			break;
+		}
+		count++;
+		bst_leftmost_range(tree->right, lo, &stack);
+	}
+	return count;
+}
+
+/*
+ * Vyhledání k-tého nejmenšího uzlu stromu (číslováno od nuly).
+ *
+ * Pokud strom nemá alespoň k+1 uzlů, funkce vrátí NULL. Při překladu
+ * s BST_ORDER_STATISTICS je cena O(výška).
+ *
+ * Funkci implementujte iterativně bez použití vlastních pomocných funkcí.
+ */
+bst_node_t *bst_select(bst_node_t *tree, int k) {
+	if (k < 0){
+		return NULL;
+	}
+
+	while (tree != NULL){
+		int left_size = BST_SIZE(tree->left);
+		if (k < left_size){
+			tree = tree->left;
+		} else if (k == left_size){
+			return tree;
+		} else {
+			// Skip the left subtree and the current node.
+			k -= left_size + 1;
+			tree = tree->right;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Pořadí klíče ve stromu, tedy počet uzlů s klíčem menším než key.
+ *
+ * Klíč se ve stromu nemusí nacházet. Při překladu s BST_ORDER_STATISTICS
+ * je cena O(výška).
+ *
+ * Funkci implementujte iterativně bez použití vlastních pomocných funkcí.
+ */
+int bst_rank(bst_node_t *tree, char key) {
+	int rank = 0;
+
+	while (tree != NULL){
+		if (key <= tree->key){
+			tree = tree->left;
+		} else {
+			// The whole left subtree and the current node are smaller than key.
+			rank += BST_SIZE(tree->left) + 1;
+			tree = tree->right;
+		}
+	}
+	return rank;
+}
@@ -7,8 +7,8 @@
 
 #include "../btree.h"
 
-// Maximální velikost zásobníku
-#define MAXSTACK 30
+// Maximální velikost zásobníku, strom s klíči typu char má nejvýše 256 úrovní
+#define MAXSTACK 256
 
 /*
  * Makro generující deklarace pro zásobník typu T s názvovým infixem TNAME.
@@ -0,0 +1,74 @@
+/*
+ * Měření paralelního průchodu, přestavby a zrušení stromu bst_i64.
+ *
+ * Použití: ./bench [počet klíčů] [největší počet vláken]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bst_par.h"
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+// The pool runs on several cores, so wall-clock time is measured.
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  int max_threads = argc > 2 ? atoi(argv[2]) : 4;
+
+  int64_t *keys = malloc(n * sizeof(int64_t));
+  if (keys == NULL) {
+    return 1;
+  }
+  for (long i = 0; i < n; i++) {
+    keys[i] = (int64_t)(bench_random() >> 1);
+  }
+
+  printf("%9s %7s %11s %11s %11s\n", "keys", "threads", "inorder ms",
+         "rebuild ms", "dispose ms");
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    par_pool_t pool;
+    if (!par_pool_init(&pool, threads)) {
+      return 1;
+    }
+    bst_i64_node_t *tree;
+    bst_i64_init(&tree);
+    for (long i = 0; i < n; i++) {
+      bst_i64_insert(&tree, keys[i], (int)i);
+    }
+
+    double start = bench_now();
+    bst_i64_items_t items = {NULL, 0, 0};
+    bst_i64_inorder_parallel(&pool, tree, &items);
+    double inorder = bench_now() - start;
+    free(items.nodes);
+
+    start = bench_now();
+    bst_i64_rebuild_parallel(&pool, &tree);
+    double rebuild = bench_now() - start;
+
+    start = bench_now();
+    bst_i64_dispose_parallel(&pool, &tree);
+    double dispose = bench_now() - start;
+
+    printf("%9ld %7d %11.1f %11.1f %11.1f\n", n, threads, inorder, rebuild,
+           dispose);
+    par_pool_dispose(&pool);
+  }
+
+  free(keys);
+  return 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * Paralelní zrušení, průchod a přestavba stromu z btree.h a stromu bst_i64.
+ */
+
+#include "bst_par.h"
+
+// Uzly z BST_POOL nelze uvolňovat z více vláken současně a pomocná vlákna
+// pool volajícího nevidí (BST_POOL je _Thread_local).
+BSTDEF_PARALLEL(bst, bst_node_free, BST_UPDATE_SIZE, BST_POOL != NULL)
+
+#define BST_PAR_NO_SIZE(NODE) ((void)0)
+BSTDEF_PARALLEL(bst_i64, BST_GEN_FREE, BST_PAR_NO_SIZE, false)
@@ -0,0 +1,253 @@
+/*
+ * Hlavičkový soubor pro paralelní zrušení, průchod a přestavbu stromu.
+ *
+ * Levý a pravý podstrom uzlu se zpracují jako samostatné úlohy ve fondu
+ * vláken z pool.h, a to až do hloubky par_pool_fork_depth. Hlubší
+ * podstromy zpracuje jedno vlákno. Degenerovaný strom (seznam) se proto
+ * mezi vlákna nerozdělí, zvládne ho ale bez přetečení zásobníku.
+ */
+#ifndef IAL_BTREE_PAR_BST_PAR_H
+#define IAL_BTREE_PAR_BST_PAR_H
+
+#include "../btree.h"
+#include "../gen/bst_gen.h"
+#include "pool.h"
+
+// Nejmenší počet uzlů, pro který se stavba stromu dělí mezi vlákna
+#define BST_PAR_GRAIN 4096
+
+/*
+ * Makro generující deklarace paralelních funkcí pro strom NAME##_node_t
+ * vygenerovaný makrem BSTDEC (nebo strom z btree.h pro NAME="bst"):
+ *   void NAME##_dispose_parallel(par_pool_t *pool, NAME##_node_t **tree)
+ *   void NAME##_inorder_parallel(par_pool_t *pool, NAME##_node_t *tree,
+ *                                NAME##_items_t *items)
+ *   void NAME##_rebuild_parallel(par_pool_t *pool, NAME##_node_t **tree)
+ *
+ * Pro pool == NULL pracují funkce na volajícím vlákně.
+ */
+#define BSTDEC_PARALLEL(NAME)                                                  \
+  void NAME##_dispose_parallel(par_pool_t *pool, NAME##_node_t **tree);        \
+  void NAME##_inorder_parallel(par_pool_t *pool, NAME##_node_t *tree,          \
+                               NAME##_items_t *items);                         \
+  void NAME##_rebuild_parallel(par_pool_t *pool, NAME##_node_t **tree);
+
+/*
+ * Makro generující implementaci funkcí deklarovaných makrem
+ * BSTDEC_PARALLEL.
+ *
+ * FREE(NODE) uvolní uzel, UPDATE_SIZE(NODE) přepočítá velikost podstromu
+ * po stavbě uzlu (viz BST_UPDATE_SIZE v btree.h) a podmínka SERIAL vynutí
+ * práci na volajícím vlákně, např. pokud FREE není vláknově bezpečné.
+ *
+ * Průchod nejdříve spočítá uzly podstromů horních úrovní a podle nich
+ * zapíše každý podstrom rovnou na jeho místo v poli items, bez spojování
+ * mezivýsledků. Pod hranicí dělení se podstromy procházejí Morrisovým
+ * algoritmem, který dočasně propojí nejpravější uzly s jejich následníky
+ * a nepotřebuje zásobník. Po dobu průchodu proto strom nesmí číst jiné
+ * vlákno. Přestavba je paralelní obdoba array_to_bst z btree.c.
+ */
+#define BSTDEF_PARALLEL(NAME, FREE, UPDATE_SIZE, SERIAL)                       \
+  typedef struct NAME##_par_job {                                              \
+    NAME##_node_t *node;   /* kořen podstromu nebo výsledek stavby */          \
+    NAME##_node_t **slots; /* pole uzlů podstromu v pořadí inorder */          \
+    int *counts;           /* počty uzlů podstromů horních úrovní */           \
+    int pos;               /* pozice uzlu v horních úrovních, kořen = 1 */     \
+    int depth;             /* zbývající počet úrovní dělení */                 \
+    int count;             /* počet uzlů podstromu */                          \
+  } NAME##_par_job_t;                                                          \
+                                                                               \
+  static void NAME##_par_dispose(par_pool_t *pool, void *arg) {                \
+    NAME##_par_job_t *job = arg;                                               \
+    NAME##_node_t *node = job->node;                                           \
+    if (node != NULL && job->depth > 0) {                                      \
+      NAME##_par_job_t left = {node->left, NULL, NULL, 0, job->depth - 1, 0};  \
+      NAME##_par_job_t right = {node->right, NULL, NULL, 0, job->depth - 1,    \
+                                0};                                            \
+      FREE(node);                                                              \
+      par_task_t task;                                                         \
+      par_fork(pool, &task, NAME##_par_dispose, &left);                        \
+      NAME##_par_dispose(pool, &right);                                        \
+      par_join(pool, &task);                                                   \
+      return;                                                                  \
+    }                                                                          \
+    while (node != NULL) {                                                     \
+      if (node->left != NULL) {                                                \
+        /* Rotate right, so the left subtree gets freed later. */              \
+        NAME##_node_t *left = node->left;                                      \
+        node->left = left->right;                                              \
+        left->right = node;                                                    \
+        node = left;                                                           \
+      } else {                                                                 \
+        NAME##_node_t *right = node->right;                                    \
+        FREE(node);                                                            \
+        node = right;                                                          \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static void NAME##_par_count(par_pool_t *pool, void *arg) {                  \
+    NAME##_par_job_t *job = arg;                                               \
+    NAME##_node_t *node = job->node;                                           \
+    job->count = 0;                                                            \
+    if (node != NULL && job->depth > 0) {                                      \
+      NAME##_par_job_t left = {node->left, NULL, job->counts, 2 * job->pos,    \
+                               job->depth - 1, 0};                             \
+      NAME##_par_job_t right = {node->right, NULL, job->counts,                \
+                                2 * job->pos + 1, job->depth - 1, 0};          \
+      par_task_t task;                                                         \
+      par_fork(pool, &task, NAME##_par_count, &left);                          \
+      NAME##_par_count(pool, &right);                                          \
+      par_join(pool, &task);                                                   \
+      job->count = 1 + left.count + right.count;                               \
+    } else {                                                                   \
+      /* Morris traversal, the visited nodes are just counted. */              \
+      while (node != NULL) {                                                   \
+        NAME##_node_t *pred = node->left;                                      \
+        if (pred != NULL) {                                                    \
+          while (pred->right != NULL && pred->right != node) {                 \
+            pred = pred->right;                                                \
+          }                                                                    \
+          if (pred->right == NULL) {                                           \
+            pred->right = node;                                                \
+            node = node->left;                                                 \
+            continue;                                                          \
+          }                                                                    \
+          pred->right = NULL;                                                  \
+        }                                                                      \
+        job->count++;                                                          \
+        node = node->right;                                                    \
+      }                                                                        \
+    }                                                                          \
+    job->counts[job->pos] = job->count;                                        \
+  }                                                                            \
+                                                                               \
+  static void NAME##_par_fill(par_pool_t *pool, void *arg) {                   \
+    NAME##_par_job_t *job = arg;                                               \
+    NAME##_node_t *node = job->node;                                           \
+    if (node != NULL && job->depth > 0) {                                      \
+      int left_count = job->counts[2 * job->pos];                              \
+      job->slots[left_count] = node;                                           \
+      NAME##_par_job_t left = {node->left, job->slots, job->counts,            \
+                               2 * job->pos, job->depth - 1, 0};               \
+      NAME##_par_job_t right = {node->right, job->slots + left_count + 1,      \
+                                job->counts, 2 * job->pos + 1,                 \
+                                job->depth - 1, 0};                            \
+      par_task_t task;                                                         \
+      par_fork(pool, &task, NAME##_par_fill, &left);                           \
+      NAME##_par_fill(pool, &right);                                           \
+      par_join(pool, &task);                                                   \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_node_t **slot = job->slots;                                         \
+    while (node != NULL) {                                                     \
+      NAME##_node_t *pred = node->left;                                        \
+      if (pred != NULL) {                                                      \
+        while (pred->right != NULL && pred->right != node) {                   \
+          pred = pred->right;                                                  \
+        }                                                                      \
+        if (pred->right == NULL) {                                             \
+          pred->right = node;                                                  \
+          node = node->left;                                                   \
+          continue;                                                            \
+        }                                                                      \
+        pred->right = NULL;                                                    \
+      }                                                                        \
+      *slot++ = node;                                                          \
+      node = node->right;                                                      \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static NAME##_node_t *NAME##_par_build_serial(NAME##_node_t **slots,         \
+                                                int count) {                   \
+    if (count == 0) {                                                          \
+      return NULL;                                                             \
+    }                                                                          \
+    int mid = count / 2;                                                       \
+    NAME##_node_t *node = slots[mid];                                          \
+    node->left = NAME##_par_build_serial(slots, mid);                          \
+    node->right = NAME##_par_build_serial(slots + mid + 1, count - mid - 1);   \
+    UPDATE_SIZE(node);                                                         \
+    return node;                                                               \
+  }                                                                            \
+                                                                               \
+  static void NAME##_par_build(par_pool_t *pool, void *arg) {                  \
+    NAME##_par_job_t *job = arg;                                               \
+    if (job->depth == 0 || job->count < BST_PAR_GRAIN) {                       \
+      job->node = NAME##_par_build_serial(job->slots, job->count);             \
+      return;                                                                  \
+    }                                                                          \
+    int mid = job->count / 2;                                                  \
+    NAME##_par_job_t left = {NULL, job->slots, NULL, 0, job->depth - 1, mid};  \
+    NAME##_par_job_t right = {NULL, job->slots + mid + 1, NULL, 0,             \
+                              job->depth - 1, job->count - mid - 1};           \
+    par_task_t task;                                                           \
+    par_fork(pool, &task, NAME##_par_build, &left);                            \
+    NAME##_par_build(pool, &right);                                            \
+    par_join(pool, &task);                                                     \
+    job->node = job->slots[mid];                                               \
+    job->node->left = left.node;                                               \
+    job->node->right = right.node;                                             \
+    UPDATE_SIZE(job->node);                                                    \
+  }                                                                            \
+                                                                               \
+  void NAME##_dispose_parallel(par_pool_t *pool, NAME##_node_t **tree) {       \
+    if (SERIAL) {                                                              \
+      pool = NULL;                                                             \
+    }                                                                          \
+    NAME##_par_job_t job = {(*tree), NULL, NULL, 1,                            \
+                            par_pool_fork_depth(pool), 0};                     \
+    NAME##_par_dispose(pool, &job);                                            \
+    (*tree) = NULL;                                                            \
+  }                                                                            \
+                                                                               \
+  void NAME##_inorder_parallel(par_pool_t *pool, NAME##_node_t *tree,          \
+                               NAME##_items_t *items) {                        \
+    if (SERIAL) {                                                              \
+      pool = NULL;                                                             \
+    }                                                                          \
+    int depth = par_pool_fork_depth(pool);                                     \
+    int *counts = malloc(((size_t)2 << depth) * sizeof(int));                  \
+    if (counts == NULL) {                                                      \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_par_job_t job = {tree, NULL, counts, 1, depth, 0};                  \
+    NAME##_par_count(pool, &job);                                              \
+                                                                               \
+    if (items->capacity < items->size + job.count) {                           \
+      NAME##_node_t **nodes = realloc(                                         \
+          items->nodes, (items->size + job.count) * sizeof(NAME##_node_t *));  \
+      if (nodes == NULL) {                                                     \
+        free(counts);                                                          \
+        return;                                                                \
+      }                                                                        \
+      items->nodes = nodes;                                                    \
+      items->capacity = items->size + job.count;                               \
+    }                                                                          \
+    job.slots = items->nodes + items->size;                                    \
+    NAME##_par_fill(pool, &job);                                               \
+    items->size += job.count;                                                  \
+    free(counts);                                                              \
+  }                                                                            \
+                                                                               \
+  void NAME##_rebuild_parallel(par_pool_t *pool, NAME##_node_t **tree) {       \
+    if (SERIAL) {                                                              \
+      pool = NULL;                                                             \
+    }                                                                          \
+    NAME##_items_t items = {NULL, 0, 0};                                       \
+    NAME##_inorder_parallel(pool, (*tree), &items);                            \
+    if (items.size == 0) {                                                     \
+      return;                                                                  \
+    }                                                                          \
+    NAME##_par_job_t job = {NULL, items.nodes, NULL, 0,                        \
+                            par_pool_fork_depth(pool), items.size};            \
+    NAME##_par_build(pool, &job);                                              \
+    (*tree) = job.node;                                                        \
+    free(items.nodes);                                                         \
+  }
+
+// Strom z btree.h a strom bst_i64 z gen/bst_gen.h
+BSTDEC_PARALLEL(bst)
+BSTDEC_PARALLEL(bst_i64)
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * Fond vláken s kradením práce (work stealing)
+ *
+ * Fronty úloh jsou chráněné zámkem. Úlohy vznikají jen nad velkými
+ * podstromy (viz par_pool_fork_depth), takže cena zámku je zanedbatelná
+ * proti práci jedné úlohy.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Index vlákna ve fondu, vlákno které fond inicializovalo má index 0
+static _Thread_local int par_worker = 0;
+
+/*
+ * Pomocná funkce která vloží úlohu na konec fronty.
+ */
+static bool par_deque_push(par_deque_t *deque, par_task_t *task) {
+  pthread_mutex_lock(&deque->lock);
+  if (deque->count == deque->capacity) {
+    int capacity = deque->capacity * 2 + 8;
+    par_task_t **tasks = malloc(capacity * sizeof(par_task_t *));
+    if (tasks == NULL) {
+      pthread_mutex_unlock(&deque->lock);
+      return false;
+    }
+    for (int i = 0; i < deque->count; i++) {
+      tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+    }
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->head = 0;
+    deque->capacity = capacity;
+  }
+  deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+  deque->count++;
+  pthread_mutex_unlock(&deque->lock);
+  return true;
+}
+
+/*
+ * Pomocná funkce která odebere úlohu z konce (steal == false) nebo ze
+ * začátku (steal == true) fronty. Pokud je fronta prázdná, vrátí NULL.
+ */
+static par_task_t *par_deque_take(par_deque_t *deque, bool steal) {
+  par_task_t *task = NULL;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->count > 0) {
+    deque->count--;
+    if (steal) {
+      task = deque->tasks[deque->head];
+      deque->head = (deque->head + 1) % deque->capacity;
+    } else {
+      task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+    }
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return task;
+}
+
+/*
+ * Pomocná funkce která najde úlohu pro aktuální vlákno. Nejdříve zkusí
+ * vlastní frontu, potom ukrade úlohu ostatním vláknům.
+ */
+static par_task_t *par_find(par_pool_t *pool) {
+  if (atomic_load(&pool->queued) == 0) {
+    return NULL;
+  }
+  par_task_t *task = par_deque_take(&pool->deques[par_worker], false);
+  for (int i = 1; task == NULL && i < pool->threads; i++) {
+    int victim = (par_worker + i) % pool->threads;
+    task = par_deque_take(&pool->deques[victim], true);
+  }
+  if (task != NULL) {
+    atomic_fetch_sub(&pool->queued, 1);
+  }
+  return task;
+}
+
+/*
+ * Pomocná funkce která spustí úlohu a označí ji za dokončenou.
+ */
+static void par_run(par_pool_t *pool, par_task_t *task) {
+  task->run(pool, task->arg);
+  atomic_store(&task->done, true);
+}
+
+/*
+ * Hlavní smyčka pomocného vlákna.
+ */
+static void *par_worker_main(void *arg) {
+  par_pool_t *pool = arg;
+  par_worker = atomic_fetch_add(&pool->started, 1);
+
+  while (!atomic_load(&pool->stop)) {
+    par_task_t *task = par_find(pool);
+    if (task != NULL) {
+      par_run(pool, task);
+      continue;
+    }
+    // Sleep until par_fork queues a task.
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stop)) {
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+  return NULL;
+}
+
+/*
+ * Inicializace fondu s threads vlákny včetně volajícího.
+ *
+ * Pokud threads není kladné, použije se počet procesorů. Úlohy lze
+ * rozdělovat jen z volajícího vlákna a z úloh běžících ve fondu a v jednom
+ * okamžiku smí být inicializovaný jen jeden fond. Pokud se nepodaří
+ * alokovat paměť nebo spustit vlákna, funkce vrátí false.
+ */
+bool par_pool_init(par_pool_t *pool, int threads) {
+  if (threads <= 0) {
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (threads <= 0) {
+    threads = 1;
+  }
+
+  pool->threads = threads;
+  pool->workers = malloc(threads * sizeof(pthread_t));
+  pool->deques = calloc(threads, sizeof(par_deque_t));
+  if (pool->workers == NULL || pool->deques == NULL) {
+    free(pool->workers);
+    free(pool->deques);
+    return false;
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+  }
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->started, 1);
+  atomic_init(&pool->stop, false);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  par_worker = 0;
+
+  for (int i = 1; i < threads; i++) {
+    if (pthread_create(&pool->workers[i], NULL, par_worker_main, pool) != 0) {
+      // Run with the workers started so far. No worker owns the deques
+      // from i on and par_pool_dispose only destroys the first i locks.
+      for (int j = i; j < threads; j++) {
+        pthread_mutex_destroy(&pool->deques[j].lock);
+      }
+      pool->threads = i;
+      break;
+    }
+  }
+  return true;
+}
+
+/*
+ * Zrušení fondu.
+ *
+ * Funkce počká na ukončení pomocných vláken. Všechny rozdělené úlohy musí
+ * být předem dokončené funkcí par_join.
+ */
+void par_pool_dispose(par_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  atomic_store(&pool->stop, true);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 1; i < pool->threads; i++) {
+    pthread_join(pool->workers[i], NULL);
+  }
+  for (int i = 0; i < pool->threads; i++) {
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->wake);
+  free(pool->workers);
+  free(pool->deques);
+  pool->threads = 0;
+  pool->workers = NULL;
+  pool->deques = NULL;
+}
+
+/*
+ * Počet úrovní stromu, na kterých se práce dělí mezi vlákna.
+ *
+ * Na hloubce log2(vlákna) + 3 vznikne zhruba osm úloh na vlákno, což stačí
+ * na vyrovnání nestejně velkých podstromů. Bez fondu nebo s jediným
+ * vláknem vrátí 0, práce se tedy nedělí vůbec.
+ */
+int par_pool_fork_depth(par_pool_t *pool) {
+  if (pool == NULL || pool->threads <= 1) {
+    return 0;
+  }
+  int depth = 3;
+  for (int threads = 1; threads < pool->threads; threads *= 2) {
+    depth++;
+  }
+  return depth;
+}
+
+/*
+ * Rozdělení práce: úloha run(pool, arg) se vloží do fronty aktuálního
+ * vlákna, odkud ji může ukrást jiné vlákno.
+ *
+ * Úlohu je nutné dokončit funkcí par_join dříve, než zanikne proměnná
+ * task. Bez fondu (pool == NULL) se úloha provede hned.
+ */
+void par_fork(par_pool_t *pool, par_task_t *task,
+              void (*run)(par_pool_t *pool, void *arg), void *arg) {
+  task->run = run;
+  task->arg = arg;
+  atomic_init(&task->done, false);
+
+  if (pool == NULL || pool->threads <= 1 ||
+      !par_deque_push(&pool->deques[par_worker], task)) {
+    par_run(pool, task);
+    return;
+  }
+  atomic_fetch_add(&pool->queued, 1);
+  pthread_mutex_lock(&pool->lock);
+  pthread_cond_signal(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Čekání na dokončení úlohy rozdělené funkcí par_fork.
+ *
+ * Pokud úlohu zatím žádné vlákno neukradlo, provede ji volající vlákno
+ * samo. Jinak mezitím zpracovává jiné úlohy, aby nečekalo nečinně.
+ */
+void par_join(par_pool_t *pool, par_task_t *task) {
+  while (!atomic_load(&task->done)) {
+    par_task_t *other = par_find(pool);
+    if (other != NULL) {
+      par_run(pool, other);
+    } else {
+      sched_yield();
+    }
+  }
+}
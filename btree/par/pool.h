@@ -0,0 +1,55 @@
+/*
+ * Hlavičkový soubor pro fond vláken s kradením práce (work stealing).
+ *
+ * Každé vlákno má vlastní frontu úloh. Nové úlohy vkládá na její konec
+ * a odtud je také samo odebírá, takže nejdříve zpracuje naposledy
+ * rozdělenou (nejmenší) část práce. Vlákno bez práce ukradne nejstarší
+ * úlohu ze začátku fronty jiného vlákna, tedy obvykle největší podstrom.
+ */
+
+#ifndef IAL_BTREE_PAR_POOL_H
+#define IAL_BTREE_PAR_POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+struct par_pool;
+
+// Úloha rozdělená funkcí par_fork
+typedef struct par_task {
+  void (*run)(struct par_pool *pool, void *arg); // funkce úlohy
+  void *arg;                                      // argument funkce
+  atomic_bool done;                               // úloha je dokončená
+} par_task_t;
+
+// Fronta úloh jednoho vlákna
+typedef struct par_deque {
+  pthread_mutex_t lock; // zámek fronty
+  par_task_t **tasks;   // kruhové pole úloh
+  int head;             // index nejstarší úlohy
+  int count;            // počet úloh
+  int capacity;         // velikost pole
+} par_deque_t;
+
+// Fond vláken, vlákno 0 je vlákno, které fond inicializovalo
+typedef struct par_pool {
+  int threads;           // počet vláken včetně volajícího
+  pthread_t *workers;    // pomocná vlákna 1 až threads-1
+  par_deque_t *deques;   // fronta každého vlákna
+  atomic_int queued;     // počet úloh ve všech frontách
+  atomic_int started;    // počet spuštěných vláken (určuje jejich index)
+  atomic_bool stop;      // pomocná vlákna mají skončit
+  pthread_mutex_t lock;  // zámek pro uspání pomocných vláken
+  pthread_cond_t wake;   // probuzení pomocných vláken
+} par_pool_t;
+
+bool par_pool_init(par_pool_t *pool, int threads);
+void par_pool_dispose(par_pool_t *pool);
+int par_pool_fork_depth(par_pool_t *pool);
+
+void par_fork(par_pool_t *pool, par_task_t *task,
+              void (*run)(par_pool_t *pool, void *arg), void *arg);
+void par_join(par_pool_t *pool, par_task_t *task);
+
+#endif
@@ -0,0 +1,123 @@
+#include "bst_par.h"
+#include "../test_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+const int base_data_count = 15;
+const char base_keys[] = {'H', 'D', 'L', 'B', 'F', 'J', 'N', 'A',
+                          'C', 'E', 'G', 'I', 'K', 'M', 'O'};
+const int base_values[] = {8, 4, 12, 2, 6, 10, 14, 1, 3, 5, 7, 9, 11, 13, 16};
+
+const int test_data_count = 200000;
+
+par_pool_t test_pool;
+
+void init_test() {
+  printf("Parallel Binary Search Tree - testing script\n");
+  printf("--------------------------------------------\n");
+  printf("\n");
+}
+
+int bst_i64_height(bst_i64_node_t *tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+  int left = bst_i64_height(tree->left);
+  int right = bst_i64_height(tree->right);
+  return 1 + (left > right ? left : right);
+}
+
+TEST(test_tree_inorder_parallel, "Traverse the tree inorder on 4 threads")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_print_tree(test_tree);
+bst_inorder_parallel(&test_pool, test_tree, test_items);
+bst_print_items(test_items);
+ENDTEST
+
+TEST(test_tree_rebuild_parallel, "Rebuild sorted keys (A-Z) on 4 threads")
+bst_init(&test_tree);
+for (char key = 'A'; key <= 'Z'; key++) {
+  bst_insert(&test_tree, key, key - 'A' + 1);
+}
+bst_rebuild_parallel(&test_pool, &test_tree);
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_tree_dispose_parallel, "Dispose the tree on 4 threads")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_dispose_parallel(&test_pool, &test_tree);
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_i64_parallel, "Traverse, rebuild and dispose many random keys")
+bst_init(&test_tree);
+bst_i64_node_t *tree;
+bst_i64_init(&tree);
+uint64_t state = 88172645463325252ULL;
+for (int i = 0; i < test_data_count; i++) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  bst_i64_insert(&tree, (int64_t)(state >> 1), i);
+}
+bst_i64_items_t serial = {NULL, 0, 0};
+bst_i64_items_t parallel = {NULL, 0, 0};
+bst_i64_inorder(tree, &serial);
+bst_i64_inorder_parallel(&test_pool, tree, &parallel);
+bool matches = serial.size == parallel.size;
+for (int i = 0; matches && i < serial.size; i++) {
+  matches = serial.nodes[i] == parallel.nodes[i];
+}
+printf("Parallel inorder matches: %s (%d nodes)\n", matches ? "yes" : "no",
+       parallel.size);
+bst_i64_rebuild_parallel(&test_pool, &tree);
+parallel.size = 0;
+bst_i64_inorder_parallel(&test_pool, tree, &parallel);
+matches = serial.size == parallel.size;
+for (int i = 0; matches && i < serial.size; i++) {
+  matches = serial.nodes[i]->key == parallel.nodes[i]->key;
+}
+printf("Rebuilt tree matches: %s, height: %d\n", matches ? "yes" : "no",
+       bst_i64_height(tree));
+free(serial.nodes);
+free(parallel.nodes);
+bst_i64_dispose_parallel(&test_pool, &tree);
+printf("Tree disposed: %s\n", tree == NULL ? "yes" : "no");
+ENDTEST
+
+TEST(test_i64_degenerate, "Traverse and dispose a degenerate tree without a pool")
+bst_init(&test_tree);
+bst_i64_node_t *tree = NULL;
+for (int i = 0; i < test_data_count; i++) {
+  bst_i64_node_t *node = malloc(sizeof(bst_i64_node_t));
+  node->key = test_data_count - i;
+  node->value = i;
+  node->left = NULL;
+  node->right = tree;
+  tree = node;
+}
+bst_i64_items_t items = {NULL, 0, 0};
+bst_i64_inorder_parallel(NULL, tree, &items);
+printf("Items: %d, first key: %ld, last key: %ld\n", items.size,
+       (long)items.nodes[0]->key, (long)items.nodes[items.size - 1]->key);
+free(items.nodes);
+bst_i64_dispose_parallel(NULL, &tree);
+printf("Tree disposed: %s\n", tree == NULL ? "yes" : "no");
+ENDTEST
+
+int main(int argc, char *argv[]) {
+  init_test();
+  if (!par_pool_init(&test_pool, 4)) {
+    return 1;
+  }
+
+  test_tree_inorder_parallel();
+  test_tree_rebuild_parallel();
+  test_tree_dispose_parallel();
+  test_i64_parallel();
+  test_i64_degenerate();
+
+  par_pool_dispose(&test_pool);
+}
@@ -30,26 +30,46 @@ void bst_init(bst_node_t **tree) {
  * value zůstává nezměněná.
  * 
  * Funkci implementujte rekurzivně bez použité vlastních pomocných funkcí.
+ *
+ * V režimu BST_SPLAY se nalezený uzel přesune do kořene (viz bst_splay).
  */
 bool bst_search(bst_node_t *tree, char key, int *value) {
+	BST_STATS_ENTER(BST_STATS_SEARCH);
 	if(tree == NULL){
+		BST_STATS_LEAVE();
 		return false;
 	}
 
+#ifndef BST_PERSISTENT
+	if(BST_SPLAY){
+		// After splaying, the key is either in the root or missing.
+		bst_splay(tree, key);
+		if(tree->key != key){
+			BST_STATS_LEAVE();
+			return false;
+		}
+	}
+#endif
+
+	BST_STATS_HOP();
+	bool found;
+
 	// If key is found, return true and store the value.
-	if(tree->key == key){
+	if(BST_STATS_CMP(tree->key == key)){
 		*value = tree->value;
-		return true;
+		found = true;
 
 	// If key is smaller than the current node, search the left subtree.
-	} else if(key < tree->key){
-		return bst_search(tree->left, key, value);
+	} else if(BST_STATS_CMP(key < tree->key)){
+		found = bst_search(tree->left, key, value);
 
 	// If key is bigger than the current node, search the right subtree.
 	} else {
-		return bst_search(tree->right, key, value);
+		found = bst_search(tree->right, key, value);
 	}
-	
+
+	BST_STATS_LEAVE();
+	return found;
 }
 
 /*
@@ -62,19 +82,43 @@ bool bst_search(bst_node_t *tree, char key, int *value) {
  * uzlu obsahuje jenom menší klíče, pravý větší. 
  *
  * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a nový uzel
+ * leží hlouběji než log_{3/2}(počet uzlů), přestaví se nejmenší nevyvážený
+ * podstrom na jeho cestě ke kořeni (obětní beránek). Amortizovaná cena
+ * vložení je pak O(log n) bez dalších údajů v uzlech.
+ *
+ * V režimu BST_SPLAY se nový uzel stane kořenem (viz bst_splay_insert).
  */
 void bst_insert(bst_node_t **tree, char key, int value) {
 	// If 'tree' pointer don't point to anything, return.
 	if(tree == NULL){
 		return;
 	}
+#ifdef BST_PERSISTENT
+	// Path copying, *tree becomes the new version (see btree.h).
+	bst_node_t *version;
+	if (bst_persistent_insert(*tree, key, value, &version)){
+		bst_persistent_release(*tree);
+		*tree = version;
+	}
+	return;
+#endif
+	BST_STATS_ENTER(BST_STATS_INSERT);
+	if(BST_SPLAY){
+		bst_splay_insert(tree, key, value);
+		BST_STATS_LEAVE();
+		return;
+	}
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
 
 	
 	if((*tree) == NULL){ // If the tree is empty.
 		// Allocate memory for inserting node.
-		bst_node_t *insert_node = (bst_node_t *) malloc(sizeof(bst_node_t));
+		bst_node_t *insert_node = bst_node_alloc();
 
 		if(insert_node == NULL){ // Allocation failed.
+			BST_STATS_LEAVE();
 			return;
 		}
 
@@ -82,23 +126,50 @@ void bst_insert(bst_node_t **tree, char key, int value) {
 		insert_node->value = value;
 		insert_node->left = NULL;
 		insert_node->right = NULL;
+		BST_UPDATE_SIZE(insert_node);
 		(*tree) = insert_node;
 
+		if(scapegoat != NULL){
+			scapegoat->size++;
+			if(scapegoat->size > scapegoat->max_size){
+				scapegoat->max_size = scapegoat->size;
+			}
+			// A node that is too deep starts the search for a scapegoat
+			// on the way back up.
+			if(bst_scapegoat_too_deep(scapegoat->depth, scapegoat->size)){
+				scapegoat->subtree_size = 1;
+			}
+		}
+
 	} else {
+		BST_STATS_HOP();
 		// If the key is equal to the current node, replace the value.
-		if((*tree)->key == key){
+		if(BST_STATS_CMP((*tree)->key == key)){
 			(*tree)->value = value;
+			BST_STATS_LEAVE();
+			return;
+		}
 
-		// If the key is smaller than the current node, insert it to the left subtree.
-		} else if(key < (*tree)->key){
-			bst_insert(&((*tree)->left), key, value);
-
-		// If the key is bigger than the current node, insert it to the right subtree.
-		} else {
-			bst_insert(&((*tree)->right), key, value);
+		// If the key is smaller than the current node, insert it to the left subtree,
+		// if it is bigger, insert it to the right subtree.
+		bool from_left = BST_STATS_CMP(key < (*tree)->key);
+		if(scapegoat != NULL){
+			scapegoat->depth++;
 		}
+		bst_insert(from_left ? &((*tree)->left) : &((*tree)->right), key, value);
+		BST_UPDATE_SIZE(*tree);
 
+		if(scapegoat != NULL){
+			scapegoat->depth--;
+			if(scapegoat->subtree_size > 0){
+				bst_scapegoat_climb(tree, from_left);
+			}
+			if(scapegoat->depth == 0){ // Back at the root.
+				scapegoat->subtree_size = 0;
+			}
+		}
 	}
+	BST_STATS_LEAVE();
 }
 /*
  * Pomocná funkce která nahradí uzel nejpravějším potomkem.
@@ -118,17 +189,19 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
 		return;
 	}
 
+	BST_STATS_HOP();
 	if((*tree)->right == NULL){ // Found the rightmost node.
 		target->key = (*tree)->key;
 		target->value = (*tree)->value;
 		// Store the left subtree of the current node.
 		bst_node_t *delete_node = (*tree);
 		(*tree) = (*tree)->left;
-		free(delete_node);
+		bst_node_free(delete_node);
 
 	// If the right subtree is not empty, search the right subtree.
 	} else {
 		bst_replace_by_rightmost(target, &((*tree)->right));
+		BST_UPDATE_SIZE(*tree);
 	}
 }
 
@@ -144,20 +217,43 @@ void bst_replace_by_rightmost(bst_node_t *target, bst_node_t **tree) {
  * 
  * Funkci implementujte rekurzivně pomocí bst_replace_by_rightmost a bez
  * použití vlastních pomocných funkcí.
+ *
+ * Pokud je nastaven stav automatického vyvažování BST_SCAPEGOAT a počet
+ * uzlů klesne pod 2/3 největšího dosaženého počtu, přestaví se celý strom.
+ *
+ * V režimu BST_SPLAY se místo toho použije bst_splay_delete.
  */
 void bst_delete(bst_node_t **tree, char key) {
     if (tree == NULL) {
         return;
     }
+#ifdef BST_PERSISTENT
+	// Path copying, *tree becomes the new version (see btree.h).
+	bst_node_t *version;
+	if (bst_persistent_delete(*tree, key, &version)){
+		bst_persistent_release(*tree);
+		*tree = version;
+	}
+	return;
+#endif
+	BST_STATS_ENTER(BST_STATS_DELETE);
+	if (BST_SPLAY) {
+		bst_splay_delete(tree, key);
+		BST_STATS_LEAVE();
+		return;
+	}
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
     if ((*tree) == NULL) {
+		BST_STATS_LEAVE();
         return;
     }
 
-	if ((*tree)->key == key) { // We found a node with target key.
+	BST_STATS_HOP();
+	if (BST_STATS_CMP((*tree)->key == key)) { // We found a node with target key.
 
 		// The node has two children.
 		if ((*tree)->left == NULL && (*tree)->right == NULL) {
-			free((*tree));
+			bst_node_free((*tree));
 			(*tree) = NULL;
 
 		// The node has only right child.
@@ -166,7 +262,7 @@ void bst_delete(bst_node_t **tree, char key) {
 			// Point the parent pointer to the olny child.
 			(*tree) = (*tree)->right;
 			// Free memory of the deleted node.
-			free(delete_node);
+			bst_node_free(delete_node);
 
 		// The node has only left child.
 		} else if ((*tree)->right == NULL) {
@@ -174,23 +270,48 @@ void bst_delete(bst_node_t **tree, char key) {
 			// Point the parent pointer to the olny child.
 			(*tree) = (*tree)->left;
 			// Free memory of the deleted node.
-			free(delete_node);
+			bst_node_free(delete_node);
 
 		// The node has both (left and right) children.
 		} else {
 			// Replace the node with the rightmost node of the left subtree,
 			// as it's written in the function description.
 			bst_replace_by_rightmost((*tree), &((*tree)->left));
+			BST_UPDATE_SIZE(*tree);
 		}
 
-	// If the key is smaller than the current node, search the left subtree.
-	} else if (key < (*tree)->key) {
-		bst_delete(&((*tree)->left), key);
+		if (scapegoat != NULL) {
+			scapegoat->size--;
+		}
 
-	// If the key is bigger than the current node, search the right subtree.
 	} else {
-		bst_delete(&((*tree)->right), key);
+		if (scapegoat != NULL) {
+			scapegoat->depth++;
+		}
+
+		// If the key is smaller than the current node, search the left subtree.
+		if (BST_STATS_CMP(key < (*tree)->key)) {
+			bst_delete(&((*tree)->left), key);
+
+		// If the key is bigger than the current node, search the right subtree.
+		} else {
+			bst_delete(&((*tree)->right), key);
+		}
+		BST_UPDATE_SIZE(*tree);
+
+		if (scapegoat != NULL) {
+			scapegoat->depth--;
+		}
 	}
+
+	// Back at the root, rebuild the whole tree once it has shrunk below
+	// 2/3 of its largest size.
+	if (scapegoat != NULL && scapegoat->depth == 0 &&
+	    scapegoat->size * 3 < scapegoat->max_size * 2) {
+		bst_rebuild(tree, scapegoat->size);
+		scapegoat->max_size = scapegoat->size;
+	}
+	BST_STATS_LEAVE();
 }
 
 /*
@@ -209,13 +330,25 @@ void bst_dispose(bst_node_t **tree) {
     if ((*tree) == NULL) {
         return;
     }
+#ifdef BST_PERSISTENT
+	// Other versions may share the nodes, only this reference is dropped.
+	bst_persistent_release(*tree);
+	*tree = NULL;
+	return;
+#endif
+	// Only the tracked tree resets the counters, not its subtrees.
+	bst_scapegoat_t *scapegoat = bst_scapegoat_of(tree);
+	if (scapegoat != NULL) {
+		scapegoat->size = 0;
+		scapegoat->max_size = 0;
+	}
 
 	// Delete the left subtree.
 	bst_dispose(&((*tree)->left));
 	// Delete the right subtree.
 	bst_dispose(&((*tree)->right));
 	// Delete the current node.
-	free((*tree));
+	bst_node_free((*tree));
 	(*tree) = NULL;
 }
 
@@ -272,3 +405,90 @@ void bst_postorder(bst_node_t *tree, bst_items_t *items) {
 	bst_postorder(tree->right, items);
 	bst_add_node_to_items(tree, items);
 }
+
+/*
+ * Průchod uzly s klíči z intervalu <lo,hi>.
+ *
+ * Pro každý uzel s klíčem z intervalu zavolejte (ve vzestupném pořadí klíčů)
+ * funkci bst_add_node_to_items. Do podstromů, které nemohou obsahovat klíč
+ * z intervalu, funkce nesestupuje, cena je tedy O(výška + počet nalezených).
+ *
+ * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ */
+void bst_range(bst_node_t *tree, char lo, char hi, bst_items_t *items) {
+	// If the tree is empty, return.
+	if(tree == NULL){
+		return;
+	}
+	// Keys smaller than lo can only be in the left subtree of a key > lo.
+	if(lo < tree->key){
+		bst_range(tree->left, lo, hi, items);
+	}
+	if(lo <= tree->key && tree->key <= hi){
+		bst_add_node_to_items(tree, items);
+	}
+	// Keys bigger than hi can only be in the right subtree of a key < hi.
+	if(tree->key < hi){
+		bst_range(tree->right, lo, hi, items);
+	}
+}
+
+/*
+ * Počet uzlů s klíči z intervalu <lo,hi>.
+ *
+ * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ */
+int bst_count_range(bst_node_t *tree, char lo, char hi) {
+	if(tree == NULL){
+		return 0;
+	}
+	int count = (lo <= tree->key && tree->key <= hi) ? 1 : 0;
+	if(lo < tree->key){
+		count += bst_count_range(tree->left, lo, hi);
+	}
+	if(tree->key < hi){
+		count += bst_count_range(tree->right, lo, hi);
+	}
+	return count;
+}
+
+/*
+ * Vyhledání k-tého nejmenšího uzlu stromu (číslováno od nuly).
+ *
+ * Pokud strom nemá alespoň k+1 uzlů, funkce vrátí NULL. Při překladu
+ * s BST_ORDER_STATISTICS je cena O(výška).
+ *
+ * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ */
+bst_node_t *bst_select(bst_node_t *tree, int k) {
+	if(tree == NULL || k < 0){
+		return NULL;
+	}
+	int left_size = BST_SIZE(tree->left);
+	if(k < left_size){
+		return bst_select(tree->left, k);
+	} else if(k == left_size){
+		return tree;
+	}
+	// Skip the left subtree and the current node.
+	return bst_select(tree->right, k - left_size - 1);
+}
+
+/*
+ * Pořadí klíče ve stromu, tedy počet uzlů s klíčem menším než key.
+ *
+ * Klíč se ve stromu nemusí nacházet. Při překladu s BST_ORDER_STATISTICS
+ * je cena O(výška).
+ *
+ * Funkci implementujte rekurzivně bez použití vlastních pomocných funkcí.
+ */
+int bst_rank(bst_node_t *tree, char key) {
+	if(tree == NULL){
+		return 0;
+	}
+	if(key <= tree->key){
+		return bst_rank(tree->left, key);
+	}
+	// The whole left subtree and the current node are smaller than key.
+	return BST_SIZE(tree->left) + 1 + bst_rank(tree->right, key);
+}
@@ -1,7 +1,11 @@
 #include "btree.h"
 #include "test_util.h"
+#if defined(GEN) || defined(EXA)
+#include "gen/bst_gen.h"
+#endif // GEN || EXA
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 const int base_data_count = 15;
 const char base_keys[] = {'H', 'D', 'L', 'B', 'F', 'J', 'N', 'A',
@@ -170,6 +174,486 @@ bst_print_tree(test_tree);
 bst_print_items(test_items);
 ENDTEST
 
+TEST(test_tree_deep_traversals, "Traverse a degenerate tree of 100 levels")
+bst_init(&test_tree);
+for (int key = 100; key > 0; key--) {
+  bst_insert(&test_tree, (char)key, key);
+}
+bst_preorder(test_tree, test_items);
+printf("Preorder: %d nodes\n", test_items->size);
+bst_reset_items(test_items);
+bst_inorder(test_tree, test_items);
+printf("Inorder: %d nodes\n", test_items->size);
+bst_reset_items(test_items);
+bst_postorder(test_tree, test_items);
+printf("Postorder: %d nodes\n", test_items->size);
+bst_reset_items(test_items);
+bst_range(test_tree, 11, 90, test_items);
+printf("Range <11,90>: %d nodes, %d counted\n", test_items->size,
+       bst_count_range(test_tree, 11, 90));
+bst_iter_t deep_iter;
+int deep_count = 0;
+bst_iter_begin(&deep_iter, test_tree);
+while (bst_iter_next(&deep_iter) != NULL) {
+  deep_count++;
+}
+bst_iter_end(&deep_iter);
+printf("Iterator: %d nodes, %s\n", deep_count,
+       deep_iter.failed ? "failed" : "completed");
+ENDTEST
+
+TEST(test_tree_iterator, "Traverse the tree using iterators")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, traversal_keys, traversal_values, traversal_data_count);
+bst_print_tree(test_tree);
+bst_iter_t iter;
+bst_iter_begin_preorder(&iter, test_tree);
+for (bst_node_t *node = bst_iter_next(&iter); node != NULL; node = bst_iter_next(&iter)) {
+  bst_add_node_to_items(node, test_items);
+}
+bst_iter_end(&iter);
+bst_print_items(test_items);
+bst_reset_items(test_items);
+bst_iter_begin(&iter, test_tree);
+for (bst_node_t *node = bst_iter_next(&iter); node != NULL; node = bst_iter_next(&iter)) {
+  bst_add_node_to_items(node, test_items);
+}
+bst_iter_end(&iter);
+bst_print_items(test_items);
+bst_reset_items(test_items);
+bst_iter_begin_postorder(&iter, test_tree);
+for (bst_node_t *node = bst_iter_next(&iter); node != NULL; node = bst_iter_next(&iter)) {
+  bst_add_node_to_items(node, test_items);
+}
+bst_print_items(test_items);
+bst_iter_end(&iter);
+ENDTEST
+
+TEST(test_tree_iterator_seek, "Seek the iterator to (E) and stop after two items")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_print_tree(test_tree);
+bst_iter_t iter;
+bst_iter_begin(&iter, test_tree);
+bst_iter_seek(&iter, 'E');
+for (int i = 0; i < 2; i++) {
+  bst_add_node_to_items(bst_iter_next(&iter), test_items);
+}
+bst_iter_end(&iter);
+bst_print_items(test_items);
+ENDTEST
+
+TEST(test_tree_range, "Traverse keys in the range (C,J)")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_range(test_tree, 'C', 'J', test_items);
+bst_print_tree(test_tree);
+bst_print_items(test_items);
+printf("Items in range: %d\n", bst_count_range(test_tree, 'C', 'J'));
+ENDTEST
+
+TEST(test_tree_pool, "Insert many values into a node pool and dispose it")
+bst_pool_t pool;
+bst_pool_init(&pool, sizeof(bst_node_t));
+BST_POOL = &pool;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_print_tree(test_tree);
+bst_node_t *deleted_node = test_tree->left->left->left;
+bst_delete(&test_tree, 'A');
+bst_insert(&test_tree, 'P', 17);
+printf("Deleted node recycled: %s\n",
+       test_tree->right->right->right->right == deleted_node ? "yes" : "no");
+bst_print_tree(test_tree);
+bst_pool_dispose(&pool);
+BST_POOL = NULL;
+bst_init(&test_tree);
+bst_print_tree(test_tree);
+ENDTEST
+
+static bool frozen_lookup(void *frozen, char key, int *value) {
+  return bst_frozen_search(frozen, key, value);
+}
+
+/*
+ * Pomocná funkce která uloží klíče sorted v pořadí Eytzinger do expected,
+ * uzel i má potomky 2i a 2i+1.
+ */
+static void eytzinger_fill(const char sorted[], int *next, char expected[],
+                           int i, int size) {
+  if (i > size) {
+    return;
+  }
+  eytzinger_fill(sorted, next, expected, 2 * i, size);
+  expected[i] = sorted[(*next)++];
+  eytzinger_fill(sorted, next, expected, 2 * i + 1, size);
+}
+
+TEST(test_tree_freeze, "Freeze the tree and search in the frozen copy")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_insert_many(&test_tree, additional_keys, additional_values,
+                additional_data_count);
+bst_print_tree(test_tree);
+bst_frozen_t frozen;
+bst_freeze(test_tree, &frozen);
+printf("Frozen keys:\n");
+for (int i = 1; i <= frozen.size; i++) {
+  printf("[%c,%d]", frozen.keys[i], frozen.values[i]);
+}
+printf("\n");
+bst_inorder(test_tree, test_items);
+char sorted[256];
+char expected[257];
+for (int i = 0; i < test_items->size; i++) {
+  sorted[i] = test_items->nodes[i]->key;
+}
+int next = 0;
+eytzinger_fill(sorted, &next, expected, 1, test_items->size);
+bool layout_matches = frozen.size == test_items->size;
+for (int i = 1; layout_matches && i <= frozen.size; i++) {
+  layout_matches = frozen.keys[i] == expected[i];
+}
+printf("Frozen layout is Eytzinger order of the sorted keys: %s\n",
+       layout_matches ? "yes" : "no");
+bst_check_lookup("Frozen search", test_tree, frozen_lookup, &frozen);
+bst_frozen_dispose(&frozen);
+ENDTEST
+
+static bool batch_lookup(void *tree, char key, int *value) {
+  bool found;
+  bst_search_batch(tree, &key, 1, value, &found);
+  return found;
+}
+
+TEST(test_tree_search_batch, "Search keys in batches with missing and repeated keys")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_insert_many(&test_tree, additional_keys, additional_values,
+                additional_data_count);
+bst_check_lookup("Batch search", test_tree, batch_lookup, test_tree);
+// Longer than BST_BATCH, so finished slots take new keys.
+const char batch_keys[] = {'F', '@', 'F', 'Z', 'A', 'a', 'F', 'Q', '@', 'Y',
+                           'H', 'T', 'A', 'K', 'H', 'F', 'B', 'Z', 'S', '@'};
+const int batch_count = sizeof(batch_keys) / sizeof(batch_keys[0]);
+int batch_values[sizeof(batch_keys)];
+bool batch_found[sizeof(batch_keys)];
+for (int i = 0; i < batch_count; i++) {
+  batch_values[i] = -1;
+}
+bst_search_batch(test_tree, batch_keys, batch_count, batch_values,
+                 batch_found);
+bool batch_matches = true;
+for (int i = 0; i < batch_count; i++) {
+  int value = -1;
+  bool found = bst_search(test_tree, batch_keys[i], &value);
+  if (found != batch_found[i] || value != batch_values[i]) {
+    batch_matches = false;
+  }
+  if (batch_found[i]) {
+    printf("[%c,%d]", batch_keys[i], batch_values[i]);
+  } else {
+    printf("[%c,-]", batch_keys[i]);
+  }
+}
+printf("\nBatch with missing and repeated keys matches bst_search: %s\n",
+       batch_matches ? "yes" : "no");
+ENDTEST
+
+TEST(test_tree_split_join, "Split the tree at (H) and join the parts back")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_node_t *less;
+bst_node_t *greater;
+bst_node_t *found = bst_split(test_tree, 'H', &less, &greater);
+bst_print_tree(less);
+bst_print_tree(greater);
+bst_print_node(found);
+printf("\n");
+test_tree = bst_join(bst_join(less, found), greater);
+bst_print_tree(test_tree);
+ENDTEST
+
+int test_sum(int a, int b) { return a + b; }
+
+TEST(test_tree_union, "Union with (A-E) and (P-Z) summing common values")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_node_t *other;
+bst_init(&other);
+bst_insert_many(&other, traversal_keys, traversal_values,
+                traversal_data_count);
+bst_insert_many(&other, additional_keys, additional_values,
+                additional_data_count);
+test_tree = bst_union(test_tree, other, test_sum);
+bst_print_tree(test_tree);
+bst_inorder(test_tree, test_items);
+bst_print_items(test_items);
+// Two degenerate chains (A-M) and (N-Z) must still give a balanced tree.
+bst_node_t *chain;
+bst_init(&chain);
+bst_init(&other);
+for (char key = 'A'; key <= 'M'; key++) {
+  bst_insert(&chain, key, 1);
+  bst_insert(&other, key + 13, 1);
+}
+chain = bst_union(chain, other, test_sum);
+printf("Union of two chains has height %d (26 nodes)\n", bst_height(chain));
+bst_dispose(&chain);
+ENDTEST
+
+TEST(test_tree_top_k, "Find the 4 nodes with the highest values")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_insert(&test_tree, 'A', 14);
+bst_node_t *top[4];
+int top_count = bst_top_k(test_tree, 4, top);
+for (int i = 0; i < top_count; i++) {
+  bst_print_node(top[i]);
+}
+printf("\n");
+bst_node_t *all[20];
+printf("Nodes with k = 20: %d\n", bst_top_k(test_tree, 20, all));
+ENDTEST
+
+TEST(test_tree_dump, "Dump a tree as DOT and JSON")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, 5);
+bst_insert(&test_tree, '"', 0);
+bst_dump(test_tree, stdout, BST_DUMP_DOT);
+bst_dump(test_tree, stdout, BST_DUMP_JSON);
+bst_dispose(&test_tree);
+
+// A degenerate tree deeper than the initial dump stack.
+for (int key = 1; key < 128; key++) {
+  bst_insert(&test_tree, (char)key, key);
+}
+FILE *dump_file = tmpfile();
+if (dump_file != NULL) {
+  for (int format = BST_DUMP_TEXT; format <= BST_DUMP_JSON; format++) {
+    rewind(dump_file);
+    bool dumped = bst_dump(test_tree, dump_file, format);
+    printf("Format %d: %s, %ld bytes\n", format, dumped ? "true" : "false",
+           ftell(dump_file));
+  }
+  fclose(dump_file);
+}
+ENDTEST
+
+static bool compact_lookup(void *compact, char key, int *value) {
+  return bst_compact_search(compact, key, value);
+}
+
+TEST(test_tree_compact, "Compact tree after inserts and deletes")
+bst_init(&test_tree);
+bst_compact_t compact;
+bst_compact_init(&compact);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+for (int i = 0; i < base_data_count; i++) {
+  bst_compact_insert(&compact, base_keys[i], base_values[i]);
+}
+bst_delete(&test_tree, 'H');
+bst_delete(&test_tree, 'A');
+bst_compact_delete(&compact, 'H');
+bst_compact_delete(&compact, 'A');
+// Deleted nodes go to the free list, new nodes must take them first.
+uint32_t used = compact.used;
+uint32_t first_free = compact.free;
+uint32_t second_free = compact.nodes[first_free].left;
+bst_insert(&test_tree, 'B', 42);
+bst_compact_insert(&compact, 'B', 42);
+bst_insert(&test_tree, 'P', 17);
+bst_compact_insert(&compact, 'P', 17);
+bst_insert(&test_tree, 'Q', 18);
+bst_compact_insert(&compact, 'Q', 18);
+bool reused = compact.used == used && compact.free == BST_COMPACT_NIL &&
+              compact.keys[first_free] == 'P' &&
+              compact.keys[second_free] == 'Q';
+printf("Freed slots reused for (P) and (Q): %s\n", reused ? "yes" : "no");
+bst_node_t *unpacked = bst_compact_unpack(&compact);
+bst_print_tree(unpacked);
+bst_check_lookup("Compact search", test_tree, compact_lookup, &compact);
+bst_dispose(&unpacked);
+bst_compact_pack(&compact, test_tree);
+unpacked = bst_compact_unpack(&compact);
+bst_print_tree(unpacked);
+bst_dispose(&unpacked);
+bst_compact_dispose(&compact);
+ENDTEST
+
+TEST(test_tree_scapegoat, "Insert sorted keys (A-Z) with automatic balancing")
+bst_scapegoat_t scapegoat;
+bst_init(&test_tree);
+bst_scapegoat_init(&scapegoat, &test_tree);
+BST_SCAPEGOAT = &scapegoat;
+for (char key = 'A'; key <= 'Z'; key++) {
+  bst_insert(&test_tree, key, key - 'A' + 1);
+}
+bst_print_tree(test_tree);
+// Other trees are not tracked, disposing one keeps the counters.
+bst_node_t *other;
+bst_init(&other);
+bst_insert(&other, 'A', 1);
+bst_insert(&other, 'B', 2);
+bst_dispose(&other);
+printf("Tracked size after disposing another tree: %d\n", scapegoat.size);
+for (char key = 'A'; key <= 'P'; key++) {
+  bst_delete(&test_tree, key);
+}
+bst_print_tree(test_tree);
+bst_dispose(&test_tree);
+BST_SCAPEGOAT = NULL;
+ENDTEST
+
+#ifndef GEN
+
+TEST(test_tree_order_statistics, "Select and rank keys after inserts and deletes")
+bst_scapegoat_t scapegoat;
+bst_init(&test_tree);
+bst_scapegoat_init(&scapegoat, &test_tree);
+BST_SCAPEGOAT = &scapegoat;
+for (char key = 'A'; key <= 'Z'; key++) {
+  bst_insert(&test_tree, key, key - 'A' + 1);
+}
+BST_SCAPEGOAT = NULL;
+bst_delete(&test_tree, 'H');
+bst_delete(&test_tree, 'M');
+bst_delete(&test_tree, 'Z');
+bst_print_tree(test_tree);
+printf("Size: %d\n", bst_size(test_tree));
+bst_add_node_to_items(bst_select(test_tree, 0), test_items);
+bst_add_node_to_items(bst_select(test_tree, 10), test_items);
+bst_add_node_to_items(bst_select(test_tree, bst_size(test_tree) - 1), test_items);
+bst_print_items(test_items);
+printf("Select past the end: %s\n",
+       bst_select(test_tree, bst_size(test_tree)) == NULL ? "NULL" : "node");
+printf("Rank of (H): %d, rank of (N): %d, rank of (Z): %d\n",
+       bst_rank(test_tree, 'H'), bst_rank(test_tree, 'N'),
+       bst_rank(test_tree, 'Z'));
+bst_reset_items(test_items);
+bst_inorder(test_tree, test_items);
+bool sizes_match = true;
+for (int i = 0; i < test_items->size; i++) {
+  bst_node_t *node = test_items->nodes[i];
+  if (bst_size(node) != bst_count_nodes(node) ||
+      bst_select(test_tree, i) != node || bst_rank(test_tree, node->key) != i) {
+    sizes_match = false;
+  }
+}
+printf("Subtree sizes match: %s\n", sizes_match ? "yes" : "no");
+ENDTEST
+
+#endif // GEN
+
+TEST(test_tree_splay, "Search (A), delete (H) and insert (P) in splay mode")
+BST_SPLAY = true;
+bst_init(&test_tree);
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+bst_print_tree(test_tree);
+bst_node_t *root = test_tree;
+int result = -1;
+bool found = bst_search(test_tree, 'A', &result);
+printf("Found (A): %s, value %d, root unchanged: %s\n", found ? "yes" : "no",
+       result, test_tree == root ? "yes" : "no");
+bst_print_tree(test_tree);
+bst_delete(&test_tree, 'H');
+bst_insert(&test_tree, 'P', 17);
+found = bst_search(test_tree, 'H', &result);
+printf("Found (H) after delete: %s\n", found ? "yes" : "no");
+bst_print_tree(test_tree);
+bst_inorder(test_tree, test_items);
+bool sizes_match = true;
+for (int i = 0; i < test_items->size; i++) {
+  bst_node_t *node = test_items->nodes[i];
+  if (bst_size(node) != bst_count_nodes(node) ||
+      (i > 0 && test_items->nodes[i - 1]->key >= node->key)) {
+    sizes_match = false;
+  }
+}
+printf("Keys ordered and subtree sizes match: %s\n",
+       sizes_match ? "yes" : "no");
+BST_SPLAY = false;
+ENDTEST
+
+#ifdef BST_STATS
+
+TEST(test_tree_stats, "Count comparisons, visited nodes and allocations")
+bst_init(&test_tree);
+bst_stats_reset();
+bst_insert_many(&test_tree, base_keys, base_values, base_data_count);
+int stats_value;
+bst_search(test_tree, 'F', &stats_value);
+bst_search(test_tree, 'X', &stats_value);
+bst_delete(&test_tree, 'H');
+const char *stats_names[] = {"search", "insert", "delete"};
+for (int op = BST_STATS_SEARCH; op <= BST_STATS_DELETE; op++) {
+  stats_op_t *stats_op = &bst_stats.ops[op];
+  printf("%s: calls %llu, comparisons %llu, hops %llu, max path %llu, "
+         "allocs %llu, frees %llu\n",
+         stats_names[op], (unsigned long long)stats_op->calls,
+         (unsigned long long)stats_op->comparisons,
+         (unsigned long long)stats_op->hops,
+         (unsigned long long)stats_op->max_hops,
+         (unsigned long long)stats_op->allocs,
+         (unsigned long long)stats_op->frees);
+}
+bst_stats_report(stdout, &bst_stats, test_tree);
+printf("Height %s the expected 4\n",
+       bst_height(test_tree) == 4 ? "matches" : "differs from");
+ENDTEST
+
+#endif // BST_STATS
+
+#ifdef BST_PERSISTENT
+
+TEST(test_tree_persistent, "Insert (P) and delete (H) in new versions of the tree")
+bst_init(&test_tree);
+bst_node_t *first = NULL;
+for (int i = 0; i < base_data_count; i++) {
+  bst_insert(&first, base_keys[i], base_values[i]);
+}
+// bst_insert and bst_delete release the old version, keep a reference.
+bst_node_t *second = bst_persistent_retain(first);
+bst_insert(&second, 'P', 17);
+bst_delete(&second, 'H');
+bst_print_tree(first);
+bst_print_tree(second);
+printf("Shared subtrees (B) and (J): %s\n",
+       first->left->left == second->left->left &&
+               first->right->left == second->right->left
+           ? "yes"
+           : "no");
+
+BST_SPLAY = true;
+bst_node_t *rejected = NULL;
+printf("Insert with BST_SPLAY rejected: %s\n",
+       !bst_persistent_insert(first, 'Q', 18, &rejected) && rejected == NULL
+           ? "yes"
+           : "no");
+BST_SPLAY = false;
+
+bst_versions_t versions;
+bst_versions_init(&versions);
+bst_versions_publish(&versions, first);
+bst_node_t *snapshot = bst_versions_snapshot(&versions);
+bst_versions_publish(&versions, second);
+int value = -1;
+bool found = bst_search(snapshot, 'H', &value);
+printf("Snapshot still has (H): %s, value %d\n", found ? "yes" : "no", value);
+bst_persistent_release(snapshot);
+bst_versions_insert(&versions, 'H', 20);
+bst_versions_delete(&versions, 'P');
+snapshot = bst_versions_snapshot(&versions);
+found = bst_search(snapshot, 'H', &value);
+printf("Current version has (H): %s, value %d\n", found ? "yes" : "no", value);
+found = bst_search(snapshot, 'P', &value);
+printf("Current version has (P): %s\n", found ? "yes" : "no");
+bst_persistent_release(snapshot);
+bst_versions_dispose(&versions);
+ENDTEST
+
+#endif // BST_PERSISTENT
+
 #ifdef EXA
 
 TEST(test_letter_count, "Count letters");
@@ -178,6 +662,119 @@ letter_count(&test_tree, "abBcCc_ 123 *");
 bst_print_tree(test_tree);
 ENDTEST
 
+TEST(test_letter_count_long, "Count letters in a long input");
+bst_init(&test_tree);
+// New keys first appear in later blocks of letter_count.
+static char long_input[200001];
+for (int i = 0; i < 200000; i++) {
+  long_input[i] = "xY "[i % 3];
+}
+long_input[70000] = 'Q';
+long_input[140001] = '7';
+long_input[199999] = '*';
+long_input[200000] = '\0';
+letter_count(&test_tree, long_input);
+bst_print_tree(test_tree);
+ENDTEST
+
+bool test_same_tree(bst_node_t *a, bst_node_t *b) {
+  if (a == NULL || b == NULL) {
+    return a == b;
+  }
+  return a->key == b->key && a->value == b->value &&
+         test_same_tree(a->left, b->left) && test_same_tree(a->right, b->right);
+}
+
+TEST(test_letter_count_parallel, "Count letters in 1, 3 and 8 threads");
+bst_init(&test_tree);
+static char parallel_input[300000];
+for (int i = 0; i < 299999; i++) {
+  parallel_input[i] = "Hello, World 42!"[(i * 7 + i / 1000) % 16];
+}
+parallel_input[299998] = '#';
+parallel_input[299999] = '\0';
+letter_count(&test_tree, parallel_input);
+int thread_counts[] = {1, 3, 8};
+for (int i = 0; i < 3; i++) {
+  bst_node_t *parallel_tree;
+  letter_count_parallel(&parallel_tree, parallel_input, 299999,
+                        thread_counts[i]);
+  printf("%d threads match letter_count: %s\n", thread_counts[i],
+         test_same_tree(test_tree, parallel_tree) ? "yes" : "no");
+  bst_dispose(&parallel_tree);
+}
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_letter_count_update, "Count letters in parts and from a file");
+bst_init(&test_tree);
+const char *parts[] = {"abB", "cCc_ ", "", "123 *"};
+for (int i = 0; i < 4; i++) {
+  letter_count_update(&test_tree, parts[i], strlen(parts[i]));
+}
+bst_print_tree(test_tree);
+bst_node_t *whole;
+letter_count(&whole, "abBcCc_ 123 *");
+printf("Parts match letter_count: %s\n",
+       test_same_tree(test_tree, whole) ? "yes" : "no");
+bst_dispose(&whole);
+
+FILE *file = fopen("letter_count_test.txt", "wb");
+if (file != NULL) {
+  fputs("Zz zz!", file);
+  fclose(file);
+}
+bool file_ok = letter_count_file(&test_tree, "letter_count_test.txt");
+remove("letter_count_test.txt");
+printf("File counted: %s\n", file_ok ? "yes" : "no");
+printf("Missing file counted: %s\n",
+       letter_count_file(&test_tree, "letter_count_missing.txt") ? "yes"
+                                                                 : "no");
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_letter_count_utf8, "Count UTF-8 characters by code point");
+bst_init(&test_tree);
+bst_u32_node_t *utf8_tree;
+bst_u32_init(&utf8_tree);
+// Invalid sequences: a lone continuation byte, a truncated character,
+// an overlong encoding and an encoded surrogate.
+const char utf8_input[] = "P\xc5\x99\xc3\xadli\xc5\xa1 \xc5\xbdLU\xc5\xa4"
+                          "OU\xc4\x8cK\xc3\x9d k\xc5\xaf\xc5\x88 "
+                          "\xe2\x80\x9e\xf0\x9f\x99\x82\xe2\x80\x9c"
+                          "\x80\xc3\xc1\x81\xed\xa0\x80!";
+letter_count_utf8(&utf8_tree, utf8_input, sizeof(utf8_input) - 1);
+bst_u32_items_t utf8_items = {NULL, 0, 0};
+bst_u32_inorder(utf8_tree, &utf8_items);
+for (int i = 0; i < utf8_items.size; i++) {
+  printf("[U+%04X,%d]", (unsigned)utf8_items.nodes[i]->key,
+         utf8_items.nodes[i]->value);
+}
+printf("\n");
+free(utf8_items.nodes);
+bst_u32_dispose(&utf8_tree);
+// 300 distinct three-byte characters (U+4E00 onwards), each twice.
+static char cjk_input[300 * 2 * 3];
+for (int i = 0; i < 600; i++) {
+  unsigned code_point = 0x4E00 + i % 300;
+  cjk_input[3 * i] = (char)(0xE0 | code_point >> 12);
+  cjk_input[3 * i + 1] = (char)(0x80 | (code_point >> 6 & 0x3F));
+  cjk_input[3 * i + 2] = (char)(0x80 | (code_point & 0x3F));
+}
+bst_u32_init(&utf8_tree);
+letter_count_utf8(&utf8_tree, cjk_input, sizeof(cjk_input));
+utf8_items = (bst_u32_items_t){NULL, 0, 0};
+bst_u32_inorder(utf8_tree, &utf8_items);
+bool all_twice = utf8_items.size == 300;
+for (int i = 0; all_twice && i < utf8_items.size; i++) {
+  all_twice = utf8_items.nodes[i]->key == 0x4E00u + i &&
+              utf8_items.nodes[i]->value == 2;
+}
+printf("300 sparse code points counted twice: %s\n", all_twice ? "yes" : "no");
+free(utf8_items.nodes);
+bst_u32_dispose(&utf8_tree);
+ENDTEST
+
 TEST(test_balance, "Count letters and balance");
 bst_init(&test_tree);
 letter_count(&test_tree, "abBcCc_ 123 *");
@@ -185,8 +782,84 @@ bst_balance(&test_tree);
 bst_print_tree(test_tree);
 ENDTEST
 
+TEST(test_build_sorted, "Build a balanced tree from sorted keys")
+const char sorted_keys[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J'};
+const int sorted_values[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+bool built = bst_build_sorted(&test_tree, sorted_keys, sorted_values, 10);
+printf("Built: %s\n", built ? "yes" : "no");
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_build_optimal, "Build an optimal tree from key frequencies")
+const char optimal_keys[] = {' ', '_', 'a', 'b', 'c', 'd', 'e', 'f', 't', 'z'};
+const int optimal_weights[] = {18, 2, 8, 1, 3, 4, 12, 2, 9, 0};
+bst_build_optimal(&test_tree, optimal_keys, optimal_weights, 10);
+bst_print_tree(test_tree);
+ENDTEST
+
+TEST(test_balance_degenerate, "Balance a degenerate tree")
+bst_init(&test_tree);
+bst_insert_many(&test_tree, traversal_keys, traversal_values,
+                traversal_data_count);
+bst_insert_many(&test_tree, additional_keys, additional_values,
+                additional_data_count);
+bst_print_tree(test_tree);
+bst_balance(&test_tree);
+bst_print_tree(test_tree);
+ENDTEST
+
 #endif // EXA
 
+#ifdef GEN
+
+TEST(test_gen_i64, "Generic tree with 64-bit keys")
+bst_init(&test_tree);
+bst_i64_node_t *i64_tree;
+bst_i64_init(&i64_tree);
+const int64_t i64_keys[] = {INT64_C(5000000000), -7, INT64_C(1) << 40, 42, 0};
+for (int i = 0; i < 5; i++) {
+  bst_i64_insert(&i64_tree, i64_keys[i], i);
+}
+bst_i64_insert(&i64_tree, 42, 10);
+bst_i64_delete(&i64_tree, 0);
+bst_i64_items_t i64_items = {NULL, 0, 0};
+bst_i64_inorder(i64_tree, &i64_items);
+printf("Traversed items:\n");
+for (int i = 0; i < i64_items.size; i++) {
+  printf("[%lld,%d]", (long long)i64_items.nodes[i]->key, i64_items.nodes[i]->value);
+}
+printf("\n");
+int result = -1;
+bool found = bst_i64_search(i64_tree, INT64_C(5000000000), &result);
+printf("Search (5000000000): %d %d\n", found, result);
+free(i64_items.nodes);
+bst_i64_dispose(&i64_tree);
+ENDTEST
+
+TEST(test_gen_str, "Generic tree with string keys")
+bst_init(&test_tree);
+bst_str_node_t *str_tree;
+bst_str_init(&str_tree);
+const char *str_keys[] = {"Ethereum", "Bitcoin", "Tether", "Cardano", "Solana"};
+for (int i = 0; i < 5; i++) {
+  bst_str_insert(&str_tree, str_keys[i], i);
+}
+bst_str_items_t str_items = {NULL, 0, 0};
+bst_str_range(str_tree, "C", "Sz", &str_items);
+printf("Traversed items:\n");
+for (int i = 0; i < str_items.size; i++) {
+  printf("[%s,%d]", str_items.nodes[i]->key, str_items.nodes[i]->value);
+}
+printf("\n");
+int result = -1;
+bool found = bst_str_search(str_tree, "Tether", &result);
+printf("Search (Tether): %d %d\n", found, result);
+free(str_items.nodes);
+bst_str_dispose(&str_tree);
+ENDTEST
+
+#endif // GEN
+
 int main(int argc, char *argv[]) {
   init_test();
 
@@ -209,9 +882,48 @@ int main(int argc, char *argv[]) {
   test_tree_preorder();
   test_tree_inorder();
   test_tree_postorder();
+  test_tree_deep_traversals();
+  test_tree_iterator();
+  test_tree_iterator_seek();
+  test_tree_range();
+  test_tree_pool();
+  test_tree_freeze();
+  test_tree_search_batch();
+  test_tree_split_join();
+  test_tree_union();
+  test_tree_top_k();
+  test_tree_dump();
+  test_tree_compact();
+#ifndef BST_PERSISTENT
+  // Persistent versions reject BST_SCAPEGOAT and BST_SPLAY (see btree.h).
+  test_tree_scapegoat();
+#ifndef GEN
+  // bst_select and bst_rank come with the rec and iter variants.
+  test_tree_order_statistics();
+#endif // GEN
+  test_tree_splay();
+#endif // BST_PERSISTENT
+#ifdef BST_STATS
+  test_tree_stats();
+#endif // BST_STATS
+#ifdef BST_PERSISTENT
+  test_tree_persistent();
+#endif // BST_PERSISTENT
 
 #ifdef EXA
   test_letter_count();
+  test_letter_count_long();
+  test_letter_count_parallel();
+  test_letter_count_update();
+  test_letter_count_utf8();
   test_balance();
+  test_build_sorted();
+  test_build_optimal();
+  test_balance_degenerate();
 #endif // EXA
+
+#ifdef GEN
+  test_gen_i64();
+  test_gen_str();
+#endif // GEN
 }
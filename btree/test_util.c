@@ -1,53 +1,12 @@
 #include "test_util.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
-
-const char *subtree_prefix = "  |";
-const char *space_prefix = "   ";
-
-char *make_prefix(char *prefix, const char *suffix) {
-  char *result = (char *)malloc(strlen(prefix) + strlen(suffix) + 1);
-  strcpy(result, prefix);
-  result = strcat(result, suffix);
-  return result;
-}
-
-void bst_print_subtree(bst_node_t *tree, char *prefix, direction_t from) {
-  if (tree != NULL) {
-    char *current_subtree_prefix = make_prefix(prefix, subtree_prefix);
-    char *current_space_prefix = make_prefix(prefix, space_prefix);
-
-    if (from == left) {
-      printf("%s\n", current_subtree_prefix);
-    }
-
-    bst_print_subtree(
-        tree->right,
-        from == left ? current_subtree_prefix : current_space_prefix, right);
-
-    printf("%s  +-", prefix);
-    bst_print_node(tree);
-    printf("\n");
-
-    bst_print_subtree(
-        tree->left,
-        from == right ? current_subtree_prefix : current_space_prefix, left);
-
-    if (from == right) {
-      printf("%s\n", current_subtree_prefix);
-    }
-
-    free(current_space_prefix);
-    free(current_subtree_prefix);
-  }
-}
 
 void bst_print_tree(bst_node_t *tree) {
   printf("Binary tree structure:\n");
   printf("\n");
   if (tree != NULL) {
-    bst_print_subtree(tree, "", none);
+    bst_dump(tree, stdout, BST_DUMP_TEXT);
   } else {
     printf("Tree is empty\n");
   }
@@ -77,6 +36,7 @@ void bst_reset_items (bst_items_t *items) {
     {
       free(items->nodes);
     }
+    items->nodes = NULL;
     items->capacity = 0;
     items->size = 0;
   }
@@ -88,3 +48,22 @@ void bst_insert_many(bst_node_t **tree, const char keys[], const int values[],
     bst_insert(tree, keys[i], values[i]);
   }
 }
+
+/*
+ * Vyhledá klíče '@' až 'Z' funkcí lookup ve struktuře structure i funkcí
+ * bst_search ve stromu tree a vypíše, zda se nalezení i hodnoty shodují.
+ */
+void bst_check_lookup(const char *name, bst_node_t *tree, bst_lookup_t lookup,
+                      void *structure) {
+  bool matches = true;
+  for (char key = '@'; key <= 'Z'; key++) {
+    int tree_value = -1;
+    int value = -1;
+    bool tree_found = bst_search(tree, key, &tree_value);
+    bool found = lookup(structure, key, &value);
+    if (tree_found != found || tree_value != value) {
+      matches = false;
+    }
+  }
+  printf("%s matches bst_search: %s\n", name, matches ? "yes" : "no");
+}
@@ -17,13 +17,16 @@
   bst_dispose(&test_tree);                                                     \
   }
 
-typedef enum direction { left, right, none } direction_t;
-
-void bst_print_subtree(bst_node_t *tree, char *prefix, direction_t from);
 void bst_print_tree(bst_node_t *tree);
 void bst_insert_many(bst_node_t **tree, const char keys[], const int values[],
                      int count);
 bst_items_t* bst_init_items();
 void bst_print_items(bst_items_t *items);
 void bst_reset_items (bst_items_t *items);
+
+// Vyhledání klíče ve struktuře, která se porovnává se stromem
+typedef bool (*bst_lookup_t)(void *structure, char key, int *value);
+
+void bst_check_lookup(const char *name, bst_node_t *tree, bst_lookup_t lookup,
+                      void *structure);
 #endif
@@ -46,21 +46,26 @@ void ht_init(ht_table_t *table) {
  * hodnotu NULL.
  */
 ht_item_t *ht_search(ht_table_t *table, char *key) {
+	HT_STATS_ENTER(HT_STATS_SEARCH);
 	int hash = get_hash(key); // Transform key to table hash index.
 	ht_item_t *item = (*table)[hash]; // Save the bucket pointer.
 
 	if (item == NULL)
 	{
+		HT_STATS_LEAVE();
 		return NULL;
 	}
 
 	while (item != NULL) {
-        if (strcmp(item->key, key)) { // stings are different.
+		HT_STATS_HOP();
+        if (HT_STATS_CMP(strcmp(item->key, key))) { // stings are different.
 			item = item->next; // Go to next item in the chain.
         } else { // strcmp returns '0' if same strings.
+			HT_STATS_LEAVE();
 			return item;
 		}
     }
+	HT_STATS_LEAVE();
     return NULL;
 }
 
@@ -73,24 +78,29 @@ ht_item_t *ht_search(ht_table_t *table, char *key) {
  * synonym zvolte nejefektivnější možnost a vložte prvek na začátek seznamu.
  */
 void ht_insert(ht_table_t *table, char *key, float value) {
-	int hash = get_hash(key); // Transform key to table hash index.
-	ht_item_t *item = (*table)[hash]; // Save the bucket pointer.
+	HT_STATS_ENTER(HT_STATS_INSERT);
+	ht_item_t *item = ht_search(table, key);
 
-	if (item != NULL) { // Bucket is not empty.
-        item->value = value; // Replace the value.
-        return;
-    }
+	if (item != NULL) { // The key is already in the table.
+		item->value = value; // Replace the value.
+		HT_STATS_LEAVE();
+		return;
+	}
 
+	int hash = get_hash(key); // Transform key to table hash index.
 	ht_item_t *insert_item = (ht_item_t *) malloc(sizeof(ht_item_t));
 	if (insert_item == NULL) // Allocation faild.
 	{
+		HT_STATS_LEAVE();
 		return;
 	}
+	HT_STATS_MEMORY(true);
 
 	insert_item->key = key;
 	insert_item->value = value;
 	insert_item->next = (*table)[hash];
 	(*table)[hash] = insert_item;
+	HT_STATS_LEAVE();
 	}
 
 /*
@@ -169,3 +179,135 @@ void ht_delete_all(ht_table_t *table) {
 		(*table)[key] = NULL;
 	}
 }
+
+/*
+ * Pomocná funkce která určí, zda prvek a patří v pořadí ht_top_k před
+ * prvek b (vyšší hodnota, při shodě menší klíč).
+ */
+static bool ht_top_before(ht_item_t *a, ht_item_t *b) {
+	if (a->value != b->value) {
+		return a->value > b->value;
+	}
+	return strcmp(a->key, b->key) < 0;
+}
+
+/*
+ * Pomocná funkce která posune prvek haldy na indexu i směrem ke kořeni.
+ * V kořeni haldy je prvek, který v pořadí ht_top_k patří na konec.
+ */
+static void ht_top_sift_up(ht_item_t *heap[], int i) {
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!ht_top_before(heap[parent], heap[i])) {
+			return;
+		}
+		ht_item_t *swap = heap[parent];
+		heap[parent] = heap[i];
+		heap[i] = swap;
+		i = parent;
+	}
+}
+
+/*
+ * Pomocná funkce která posune prvek haldy velikosti size na indexu i
+ * směrem k listům.
+ */
+static void ht_top_sift_down(ht_item_t *heap[], int size, int i) {
+	while (2 * i + 1 < size) {
+		int child = 2 * i + 1;
+		if (child + 1 < size && ht_top_before(heap[child], heap[child + 1])) {
+			child++;
+		}
+		if (!ht_top_before(heap[i], heap[child])) {
+			return;
+		}
+		ht_item_t *swap = heap[child];
+		heap[child] = heap[i];
+		heap[i] = swap;
+		i = child;
+	}
+}
+
+/*
+ * Nalezení k prvků s nejvyššími hodnotami.
+ *
+ * Prvky se zapíšou do pole top (o velikosti alespoň k) sestupně podle
+ * hodnoty, prvky se stejnou hodnotou vzestupně podle klíče. Funkce vrátí
+ * počet zapsaných prvků, nejvýše k. Tabulka se projde jednou a prvky
+ * procházejí haldou v poli top, v jejímž kořeni je nejhorší z dosud
+ * vybraných prvků. Čas je tedy O(n log k) a kromě pole top funkce
+ * nepotřebuje žádnou paměť.
+ */
+int ht_top_k(ht_table_t *table, int k, ht_item_t *top[]) {
+	if (k <= 0) {
+		return 0;
+	}
+
+	int size = 0;
+	for (int i = 0; i < HT_SIZE; i++) {
+		for (ht_item_t *item = (*table)[i]; item != NULL; item = item->next) {
+			if (size < k) {
+				top[size] = item;
+				ht_top_sift_up(top, size);
+				size++;
+			} else if (ht_top_before(item, top[0])) {
+				top[0] = item;
+				ht_top_sift_down(top, size, 0);
+			}
+		}
+	}
+
+	// Heap sort, the worst item goes to the end.
+	for (int last = size - 1; last > 0; last--) {
+		ht_item_t *swap = top[0];
+		top[0] = top[last];
+		top[last] = swap;
+		ht_top_sift_down(top, last, 0);
+	}
+	return size;
+}
+
+#ifdef HT_STATS
+
+_Thread_local stats_t ht_stats;
+
+/*
+ * Vynulování počítadel ht_stats aktuálního vlákna.
+ */
+void ht_stats_reset(void) {
+	stats_t empty = {0};
+	ht_stats = empty;
+}
+
+/*
+ * Výpis souhrnu počítadel stats (např. ht_stats aktuálního vlákna) a délek
+ * seznamů synonym v tabulce table.
+ *
+ * Pro každou operaci vypíše počet volání, průměrný počet porovnání klíčů
+ * a prošlých prvků (délku průchodu seznamem) na volání, nejdelší průchod,
+ * alokace a percentily p50, p99 a p999 doby trvání.
+ */
+void ht_stats_report(FILE *out, const stats_t *stats, ht_table_t *table) {
+	int items = 0;
+	int used = 0;
+	int longest = 0;
+	for (int i = 0; i < HT_SIZE; i++) {
+		int length = 0;
+		for (ht_item_t *item = (*table)[i]; item != NULL; item = item->next) {
+			length++;
+		}
+		items += length;
+		used += length > 0;
+		if (length > longest) {
+			longest = length;
+		}
+	}
+
+	fprintf(out, "Items %d, used buckets %d of %d, chain avg %.2f max %d\n",
+	        items, used, HT_SIZE, used > 0 ? (double)items / used : 0.0,
+	        longest);
+	stats_print_op(out, "search", &stats->ops[HT_STATS_SEARCH]);
+	stats_print_op(out, "insert", &stats->ops[HT_STATS_INSERT]);
+}
+
+#endif // HT_STATS
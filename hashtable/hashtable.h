@@ -7,6 +7,10 @@
 #define IAL_HASHTABLE_H
 
 #include <stdbool.h>
+#include <stdio.h>
+#ifdef HT_STATS
+#include "../stats/stats.h"
+#endif
 
 /*
  * Maximálna veľkosť poľa pre implementáciu tabuľky.
@@ -31,6 +35,31 @@ typedef struct ht_item {
 // Tabuľka o reálnej veľkosti MAX_HT_SIZE
 typedef ht_item_t *ht_table_t[MAX_HT_SIZE];
 
+/*
+ * Meranie operácií ht_search a ht_insert (viď ../stats/stats.h). Pri
+ * preklade s HT_STATS má každé vlákno počítadlá ht_stats, inak sa makrá
+ * preložia na nič. Návštevy prvkov (HT_STATS_HOP) sú dĺžky prechodov
+ * zoznamami synoným.
+ */
+#ifdef HT_STATS
+// Index operácie v ht_stats.ops
+typedef enum ht_stats_op { HT_STATS_SEARCH, HT_STATS_INSERT } ht_stats_op_t;
+
+extern _Thread_local stats_t ht_stats;
+
+#define HT_STATS_ENTER(OP) stats_enter(&ht_stats, (OP))
+#define HT_STATS_LEAVE() stats_leave(&ht_stats)
+#define HT_STATS_CMP(EXPR) stats_compare(&ht_stats, (EXPR))
+#define HT_STATS_HOP() stats_hop(&ht_stats)
+#define HT_STATS_MEMORY(ALLOCATED) stats_memory(&ht_stats, (ALLOCATED))
+#else
+#define HT_STATS_ENTER(OP) ((void)0)
+#define HT_STATS_LEAVE() ((void)0)
+#define HT_STATS_CMP(EXPR) (EXPR)
+#define HT_STATS_HOP() ((void)0)
+#define HT_STATS_MEMORY(ALLOCATED) ((void)0)
+#endif
+
 int get_hash(char *key);
 void ht_init(ht_table_t *table);
 ht_item_t *ht_search(ht_table_t *table, char *key);
@@ -38,5 +67,10 @@ void ht_insert(ht_table_t *table, char *key, float data);
 float *ht_get(ht_table_t *table, char *key);
 void ht_delete(ht_table_t *table, char *key);
 void ht_delete_all(ht_table_t *table);
+int ht_top_k(ht_table_t *table, int k, ht_item_t *top[]);
+#ifdef HT_STATS
+void ht_stats_reset(void);
+void ht_stats_report(FILE *out, const stats_t *stats, ht_table_t *table);
+#endif
 
 #endif
@@ -76,6 +76,44 @@ INSERT_TEST_DATA(test_table)
 ht_delete_all(test_table);
 ENDTEST
 
+TEST(test_top_k, "Find the 5 items with the highest values")
+ht_init(test_table);
+INSERT_TEST_DATA(test_table)
+ht_item_t *top[5];
+int top_count = ht_top_k(test_table, 5, top);
+for (int i = 0; i < top_count; i++) {
+  printf("(%s,%.2f)", top[i]->key, top[i]->value);
+}
+printf("\n");
+ht_item_t *all[20];
+int all_count = ht_top_k(test_table, 20, all);
+printf("Items with k = 20: %d, last: (%s,%.2f)\n", all_count,
+       all[all_count - 1]->key, all[all_count - 1]->value);
+ENDTEST
+
+#ifdef HT_STATS
+TEST(test_stats, "Count comparisons and chain walks")
+ht_init(test_table);
+ht_stats_reset();
+INSERT_TEST_DATA(test_table)
+ht_search(test_table, "Ethereum");
+ht_search(test_table, "Monero");
+ht_insert(test_table, "Bitcoin", 1.0);
+stats_op_t *search_stats = &ht_stats.ops[HT_STATS_SEARCH];
+stats_op_t *insert_stats = &ht_stats.ops[HT_STATS_INSERT];
+printf("search: calls %llu, comparisons %llu, hops %llu\n",
+       (unsigned long long)search_stats->calls,
+       (unsigned long long)search_stats->comparisons,
+       (unsigned long long)search_stats->hops);
+printf("insert: calls %llu, comparisons %llu, hops %llu, allocs %llu\n",
+       (unsigned long long)insert_stats->calls,
+       (unsigned long long)insert_stats->comparisons,
+       (unsigned long long)insert_stats->hops,
+       (unsigned long long)insert_stats->allocs);
+ht_stats_report(stdout, &ht_stats, test_table);
+ENDTEST
+#endif // HT_STATS
+
 int main(int argc, char *argv[]) {
   init_uninitialized_item();
   init_test();
@@ -90,6 +128,10 @@ int main(int argc, char *argv[]) {
   test_get();
   test_delete();
   test_delete_all();
+  test_top_k();
+#ifdef HT_STATS
+  test_stats();
+#endif
 
   free(uninitialized_item);
 }
@@ -0,0 +1,130 @@
+/*
+ * Měření operací datových struktur (viz stats.h)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+#include <time.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATS_UNIT "cycles"
+#else
+#define STATS_UNIT "ns"
+#endif
+
+/*
+ * Hodnota čítače cyklů procesoru. Na procesorech bez instrukce rdtsc
+ * se místo cyklů vrátí nanosekundy monotónních hodin.
+ */
+uint64_t stats_cycles(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/*
+ * Pomocná funkce která vrátí index přihrádky histogramu pro hodnotu.
+ *
+ * Hodnoty menší než STATS_SUB_BUCKETS mají vlastní přihrádku, větší
+ * hodnoty se dělí podle nejvyššího bitu a tří bitů za ním.
+ */
+static int stats_bucket(uint64_t value) {
+  if (value < STATS_SUB_BUCKETS) {
+    return (int)value;
+  }
+  int exponent = 63 - __builtin_clzll(value);
+  int sub = (int)(value >> (exponent - 3)) & (STATS_SUB_BUCKETS - 1);
+  return (exponent - 2) * STATS_SUB_BUCKETS + sub;
+}
+
+/*
+ * Pomocná funkce která vrátí největší hodnotu přihrádky index.
+ */
+static uint64_t stats_bucket_max(int index) {
+  if (index < STATS_SUB_BUCKETS) {
+    return (uint64_t)index;
+  }
+  int exponent = index / STATS_SUB_BUCKETS + 2;
+  uint64_t sub = (uint64_t)(index % STATS_SUB_BUCKETS);
+  uint64_t width = (uint64_t)1 << (exponent - 3);
+  return (STATS_SUB_BUCKETS + sub) * width + width - 1;
+}
+
+/*
+ * Přidání hodnoty do histogramu.
+ */
+void stats_histogram_add(stats_histogram_t *histogram, uint64_t value) {
+  histogram->counts[stats_bucket(value)]++;
+  histogram->total++;
+}
+
+/*
+ * Hodnota, pod kterou (včetně) leží podíl fraction všech hodnot
+ * histogramu, např. 0.99 pro p99. Výsledek je horní mez přihrádky,
+ * tedy nejvýše o 12,5 % větší než přesný percentil. Prázdný histogram
+ * vrátí 0.
+ */
+uint64_t stats_histogram_percentile(const stats_histogram_t *histogram,
+                                    double fraction) {
+  if (histogram->total == 0) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)(fraction * (double)histogram->total);
+  if (rank >= histogram->total) {
+    rank = histogram->total - 1;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < STATS_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen > rank) {
+      return stats_bucket_max(i);
+    }
+  }
+  return stats_bucket_max(STATS_BUCKETS - 1);
+}
+
+/*
+ * Přičtení počítadel stats (např. jiného vlákna) k total.
+ */
+void stats_merge(stats_t *total, const stats_t *stats) {
+  for (int op = 0; op < STATS_MAX_OPS; op++) {
+    stats_op_t *to = &total->ops[op];
+    const stats_op_t *from = &stats->ops[op];
+    to->calls += from->calls;
+    to->comparisons += from->comparisons;
+    to->hops += from->hops;
+    if (from->max_hops > to->max_hops) {
+      to->max_hops = from->max_hops;
+    }
+    to->allocs += from->allocs;
+    to->frees += from->frees;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+      to->latency.counts[i] += from->latency.counts[i];
+    }
+    to->latency.total += from->latency.total;
+  }
+}
+
+/*
+ * Výpis jednoho řádku souhrnu operace: počet volání, průměrný počet
+ * porovnání a navštívených uzlů (délka cesty) na volání, nejdelší cesta,
+ * alokace, uvolnění a percentily doby trvání.
+ */
+void stats_print_op(FILE *out, const char *name, const stats_op_t *op) {
+  double calls = op->calls > 0 ? (double)op->calls : 1;
+  fprintf(out,
+          "%-8s calls %-9llu cmp/op %6.2f path %6.2f max %4llu "
+          "alloc %-7llu free %-7llu p50 %llu p99 %llu p999 %llu %s\n",
+          name, (unsigned long long)op->calls, op->comparisons / calls,
+          op->hops / calls, (unsigned long long)op->max_hops,
+          (unsigned long long)op->allocs, (unsigned long long)op->frees,
+          (unsigned long long)stats_histogram_percentile(&op->latency, 0.5),
+          (unsigned long long)stats_histogram_percentile(&op->latency, 0.99),
+          (unsigned long long)stats_histogram_percentile(&op->latency, 0.999),
+          STATS_UNIT);
+}
@@ -0,0 +1,131 @@
+/*
+ * Hlavičkový soubor pro měření operací datových struktur.
+ *
+ * Modul btree se měří při překladu s BST_STATS, modul hashtable s HT_STATS.
+ * Bez těchto přepínačů se měřicí makra přeloží na nic a měření nic nestojí.
+ *
+ * Každé vlákno má vlastní počítadla (stats_t), takže se měření mezi vlákny
+ * nesynchronizuje. Měřená operace může volat jiné měřené operace (rekurze,
+ * ht_insert volá ht_search), všechna porovnání, přechody a alokace se ale
+ * připíšou vnější operaci. Doba trvání se měří čítačem cyklů procesoru
+ * u každého STATS_SAMPLE-tého volání.
+ */
+#ifndef IAL_STATS_STATS_H
+#define IAL_STATS_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Největší počet měřených operací jednoho modulu
+#define STATS_MAX_OPS 4
+
+// Doba trvání se měří u každého STATS_SAMPLE-tého volání operace
+#define STATS_SAMPLE 16
+
+// Počet přihrádek histogramu na každou mocninu dvou (přesnost 12,5 %)
+#define STATS_SUB_BUCKETS 8
+
+// Počet přihrádek histogramu pro hodnoty do 2^64
+#define STATS_BUCKETS (62 * STATS_SUB_BUCKETS)
+
+// Histogram s logaritmicky rostoucími přihrádkami
+typedef struct stats_histogram {
+  uint64_t counts[STATS_BUCKETS]; // počty hodnot v přihrádkách
+  uint64_t total;                 // počet všech hodnot
+} stats_histogram_t;
+
+// Počítadla jedné operace
+typedef struct stats_op {
+  uint64_t calls;              // počet volání
+  uint64_t comparisons;        // počet porovnání klíčů
+  uint64_t hops;               // počet navštívených uzlů nebo prvků
+  uint64_t max_hops;           // nejvíce navštívených uzlů v jednom volání
+  uint64_t allocs;             // počet alokací
+  uint64_t frees;              // počet uvolnění
+  stats_histogram_t latency;   // doba trvání vzorkovaných volání
+} stats_op_t;
+
+// Počítadla operací jednoho modulu v jednom vlákně
+typedef struct stats {
+  stats_op_t ops[STATS_MAX_OPS]; // počítadla podle indexu operace
+  int depth;                     // hloubka vnoření měřených operací
+  int current;                   // index vnější operace
+  uint64_t path;                 // navštívené uzly aktuálního volání
+  uint64_t start;                // začátek vzorkovaného volání, jinak 0
+} stats_t;
+
+uint64_t stats_cycles(void);
+void stats_histogram_add(stats_histogram_t *histogram, uint64_t value);
+uint64_t stats_histogram_percentile(const stats_histogram_t *histogram,
+                                    double fraction);
+void stats_merge(stats_t *total, const stats_t *stats);
+void stats_print_op(FILE *out, const char *name, const stats_op_t *op);
+
+/*
+ * Začátek operace op. Vnořené volání jen zvýší hloubku vnoření.
+ */
+static inline void stats_enter(stats_t *stats, int op) {
+  if (stats->depth++ > 0) {
+    return;
+  }
+  stats->current = op;
+  stats->path = 0;
+  stats->start = 0;
+  if (++stats->ops[op].calls % STATS_SAMPLE == 0) {
+    stats->start = stats_cycles();
+  }
+}
+
+/*
+ * Konec operace začaté funkcí stats_enter.
+ */
+static inline void stats_leave(stats_t *stats) {
+  if (--stats->depth > 0) {
+    return;
+  }
+  stats_op_t *op = &stats->ops[stats->current];
+  if (stats->path > op->max_hops) {
+    op->max_hops = stats->path;
+  }
+  if (stats->start != 0) {
+    stats_histogram_add(&op->latency, stats_cycles() - stats->start);
+  }
+}
+
+/*
+ * Porovnání klíčů, vrátí jeho výsledek.
+ */
+static inline bool stats_compare(stats_t *stats, bool result) {
+  stats->ops[stats->current].comparisons++;
+  return result;
+}
+
+/*
+ * Návštěva uzlu nebo prvku. Mimo měřené operace se nepočítá (např.
+ * bst_replace_by_rightmost volaná přímo).
+ */
+static inline void stats_hop(stats_t *stats) {
+  if (stats->depth == 0) {
+    return;
+  }
+  stats->ops[stats->current].hops++;
+  stats->path++;
+}
+
+/*
+ * Alokace (allocated == true) nebo uvolnění paměti. Mimo měřené operace
+ * se nepočítá.
+ */
+static inline void stats_memory(stats_t *stats, bool allocated) {
+  if (stats->depth == 0) {
+    return;
+  }
+  if (allocated) {
+    stats->ops[stats->current].allocs++;
+  } else {
+    stats->ops[stats->current].frees++;
+  }
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Měření počítání slov a bigramů na velkém textu.
+ *
+ * Bez argumentu se vygeneruje text se slovníkem BENCH_VOCABULARY slov
+ * a Zipfovým rozdělením četností slov (jako v přirozeném jazyce) a uloží
+ * se do dočasného souboru. Jinak se použije zadaný soubor.
+ *
+ * Použití: ./bench [soubor | -velikost textu v MB]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_VOCABULARY 200000
+
+static uint64_t bench_state = 88172645463325252ULL;
+
+static uint64_t bench_random(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+static double bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/*
+ * Zapíše do souboru path text délky alespoň megabytes MB.
+ */
+static bool bench_generate(const char *path, long megabytes) {
+  FILE *file = fopen(path, "wb");
+  char(*words)[16] = malloc(BENCH_VOCABULARY * sizeof(*words));
+  double *cdf = malloc(BENCH_VOCABULARY * sizeof(double));
+  if (file == NULL || words == NULL || cdf == NULL) {
+    if (file != NULL) {
+      fclose(file);
+    }
+    free(words);
+    free(cdf);
+    return false;
+  }
+
+  double total = 0;
+  for (int i = 0; i < BENCH_VOCABULARY; i++) {
+    int length = 2 + (int)(bench_random() % 10);
+    for (int c = 0; c < length; c++) {
+      words[i][c] = (char)('a' + bench_random() % 26);
+    }
+    words[i][length] = '\0';
+    total += 1.0 / (i + 1);
+    cdf[i] = total;
+  }
+
+  long written = 0;
+  while (written < megabytes << 20) {
+    double u = (double)(bench_random() >> 11) / (1ULL << 53) * total;
+    int low = 0;
+    int high = BENCH_VOCABULARY - 1;
+    while (low < high) {
+      int mid = (low + high) / 2;
+      if (cdf[mid] < u) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    written += fprintf(file, bench_random() % 12 == 0 ? "%s. " : "%s ",
+                       words[low]);
+  }
+
+  fclose(file);
+  free(words);
+  free(cdf);
+  return true;
+}
+
+/*
+ * Spočítá tokeny souboru path v shard_count tabulkách (0 = podle velikosti
+ * souboru) a vypíše časy jednotlivých kroků.
+ */
+static void bench_run(const char *path, int n, size_t expected_tokens,
+                      const char *name) {
+  double start = bench_now();
+  text_input_t input;
+  if (!text_map(&input, path)) {
+    printf("[W] Cannot map %s\n", path);
+    return;
+  }
+  double map = bench_now() - start;
+
+  text_counts_t counts;
+  text_counts_init(&counts, expected_tokens);
+  start = bench_now();
+  text_count(&counts, input.data, input.length, n);
+  double count = bench_now() - start;
+
+  start = bench_now();
+  bst_str_node_t *tree = text_sorted(&counts);
+  bst_str_items_t items = {NULL, 0, 0};
+  bst_str_inorder(tree, &items);
+  double sort = bench_now() - start;
+
+  double megabytes = input.length / 1048576.0;
+  printf("%-12s %2d %6zu %9zu %8.3f %8.3f %8.1f %8.3f\n", name, n,
+         counts.shard_count, counts.size, map, count, megabytes / count,
+         sort);
+  for (int i = 1; i < items.size; i++) {
+    if (strcmp(items.nodes[i - 1]->key, items.nodes[i]->key) >= 0) {
+      printf("[W] Tokens are not sorted\n");
+      break;
+    }
+  }
+  free(items.nodes);
+  bst_str_dispose(&tree);
+  text_counts_dispose(&counts);
+  text_unmap(&input);
+}
+
+int main(int argc, char *argv[]) {
+  char path[] = "/tmp/text_bench_XXXXXX";
+  const char *corpus = path;
+  long megabytes = 256;
+  if (argc > 1 && argv[1][0] != '-') {
+    corpus = argv[1];
+  } else {
+    if (argc > 1) {
+      megabytes = atol(argv[1] + 1);
+    }
+    int fd = mkstemp(path);
+    if (fd < 0) {
+      return 1;
+    }
+    close(fd);
+    if (!bench_generate(path, megabytes)) {
+      unlink(path);
+      return 1;
+    }
+  }
+
+  printf("%-12s %2s %6s %9s %8s %8s %8s %8s\n", "tables", "n", "shards",
+         "distinct", "map [s]", "count[s]", "MB/s", "sort [s]");
+  bench_run(corpus, 1, (size_t)1 << 20, "sized");
+  bench_run(corpus, 2, (size_t)1 << 24, "sized");
+
+  // A single table of HT_SIZE chains, on a smaller text.
+  if (corpus == path) {
+    bench_generate(path, 4);
+    bench_run(corpus, 1, (size_t)1 << 20, "sized 4 MB");
+    bench_run(corpus, 1, 0, "single 4 MB");
+    unlink(path);
+  }
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "text.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST(NAME, DESCRIPTION)                                                \
+  void NAME() {                                                                \
+    printf("[%s] %s\n", #NAME, DESCRIPTION);                                   \
+    text_counts_t test_counts;                                                 \
+    text_counts_init(&test_counts, 0);
+
+#define ENDTEST                                                                \
+  printf("\n");                                                                \
+  text_counts_dispose(&test_counts);                                           \
+  }
+
+const char test_text[] = "The cat sat on the mat. THE CAT! the end";
+
+void init_test() {
+  printf("Word and n-gram counting - testing script\n");
+  printf("-----------------------------------------\n");
+  printf("\n");
+}
+
+void text_print_sorted(text_counts_t *counts) {
+  bst_str_node_t *tree = text_sorted(counts);
+  bst_str_items_t items = {NULL, 0, 0};
+  bst_str_inorder(tree, &items);
+  for (int i = 0; i < items.size; i++) {
+    printf("(%s,%d)", items.nodes[i]->key, items.nodes[i]->value);
+  }
+  printf("\nDistinct tokens: %zu, dropped: %lu\n", counts->size,
+         (unsigned long)counts->dropped);
+  free(items.nodes);
+  bst_str_dispose(&tree);
+}
+
+TEST(test_count_words, "Count words of a sentence")
+char text[sizeof(test_text)];
+memcpy(text, test_text, sizeof(test_text));
+text_count(&test_counts, text, strlen(text), 1);
+text_print_sorted(&test_counts);
+ENDTEST
+
+TEST(test_count_words_twice, "Count words of the same text twice")
+char text[sizeof(test_text)];
+memcpy(text, test_text, sizeof(test_text));
+size_t length = strlen(text);
+text_count(&test_counts, text, length, 1);
+text_count(&test_counts, text, length, 1);
+text_print_sorted(&test_counts);
+ENDTEST
+
+TEST(test_count_bigrams, "Count bigrams of a sentence")
+char text[sizeof(test_text)];
+memcpy(text, test_text, sizeof(test_text));
+text_count(&test_counts, text, strlen(text), 2);
+text_print_sorted(&test_counts);
+printf("Text unchanged: %s\n", strcmp(text, test_text) == 0 ? "yes" : "no");
+ENDTEST
+
+TEST(test_count_trigrams_short, "Count trigrams of a two word text")
+char text[] = "two words";
+text_count(&test_counts, text, strlen(text), 3);
+text_print_sorted(&test_counts);
+ENDTEST
+
+TEST(test_count_many_words, "Count 20000 distinct words in 8192 tables")
+text_counts_dispose(&test_counts);
+text_counts_init(&test_counts, 2000000);
+printf("Tables: %zu\n", test_counts.shard_count);
+char *text = malloc(20000 * 8);
+size_t length = 0;
+for (int round = 0; round < 2; round++) {
+  for (int i = 0; i < 10000; i++) {
+    length += sprintf(text + length, "w%d ", i * 2 + round);
+  }
+}
+text_count(&test_counts, text, length, 1);
+bst_str_node_t *tree = text_sorted(&test_counts);
+bst_str_items_t items = {NULL, 0, 0};
+bst_str_inorder(tree, &items);
+bool sorted = items.size == 20000;
+for (int i = 1; sorted && i < items.size; i++) {
+  sorted = strcmp(items.nodes[i - 1]->key, items.nodes[i]->key) < 0 &&
+           items.nodes[i]->value == 1;
+}
+printf("Distinct tokens: %zu, sorted: %s\n", test_counts.size,
+       sorted ? "yes" : "no");
+free(items.nodes);
+bst_str_dispose(&tree);
+free(text);
+ENDTEST
+
+TEST(test_count_file, "Count words of a mapped file")
+FILE *file = fopen("text_test.txt", "wb");
+if (file != NULL) {
+  fputs("Zero copy words, zero copy TOKENS", file);
+  fclose(file);
+}
+text_input_t input;
+bool mapped = text_map(&input, "text_test.txt");
+remove("text_test.txt");
+printf("Mapped: %s, length: %zu\n", mapped ? "yes" : "no", input.length);
+text_count(&test_counts, input.data, input.length, 1);
+text_print_sorted(&test_counts);
+text_counts_dispose(&test_counts);
+text_unmap(&input);
+text_counts_init(&test_counts, 0);
+printf("Missing file mapped: %s\n",
+       text_map(&input, "text_missing.txt") ? "yes" : "no");
+ENDTEST
+
+int main(int argc, char *argv[]) {
+  init_test();
+
+  test_count_words();
+  test_count_words_twice();
+  test_count_bigrams();
+  test_count_trigrams_short();
+  test_count_many_words();
+  test_count_file();
+}
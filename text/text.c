@@ -0,0 +1,421 @@
+/*
+ * Počítání slov a n-gramů v textu
+ *
+ * Slovo je nejdelší úsek písmen a číslic ASCII a bajtů nad 127 (tedy
+ * i znaků UTF-8 mimo ASCII), písmena ASCII se převedou na malá. Slova se
+ * nekopírují: tokeny ukazují přímo do textu a slovo se ukončí nulou
+ * zapsanou na místo oddělovače za ním. Soubor se proto mapuje jako
+ * soukromý (MAP_PRIVATE), zápisy se do souboru nepropíšou.
+ *
+ * Tabulka z ../hashtable má nejvýše MAX_HT_SIZE řetězců synonym. Tokeny
+ * se proto rozdělí do pole tabulek další rozptylovací funkcí (FNV-1a),
+ * aby řetězce synonym zůstaly krátké. Hodnota položky tabulky (float) je
+ * index tokenu do pole počtů, protože float přesně vyjádří jen celá čísla
+ * do 2^24 a počty častých slov velkého textu jsou vyšší.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "text.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Průměrná délka řetězce synonym, pro kterou text_counts_init volí počet
+// tabulek
+#define TEXT_CHAIN_LENGTH 4
+// Největší počet tabulek
+#define TEXT_MAX_SHARDS 65536
+
+/*
+ * Namapování souboru path do paměti.
+ *
+ * Stránky jsou soukromé a zapisovatelné, text_count s n = 1 do nich
+ * zapisuje konce slov. Prázdný soubor má data == NULL a délku 0. Pokud
+ * soubor nelze otevřít nebo namapovat, funkce vrátí false.
+ */
+bool text_map(text_input_t *input, const char *path) {
+  input->data = NULL;
+  input->length = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+    close(fd);
+    return false;
+  }
+  if (status.st_size > 0) {
+    size_t length = (size_t)status.st_size;
+    void *data =
+        mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    posix_madvise(data, length, POSIX_MADV_SEQUENTIAL);
+    input->data = data;
+    input->length = length;
+  }
+  close(fd);
+  return true;
+}
+
+/*
+ * Zrušení mapování souboru. Tokeny, které ukazují do souboru, jsou pak
+ * neplatné.
+ */
+void text_unmap(text_input_t *input) {
+  if (input->data != NULL) {
+    munmap(input->data, input->length);
+  }
+  input->data = NULL;
+  input->length = 0;
+}
+
+/*
+ * Inicializace počtů tokenů.
+ *
+ * Počet tabulek se zvolí podle očekávaného počtu různých tokenů
+ * expected_tokens tak, aby řetězce synonym měly v průměru nejvýše
+ * TEXT_CHAIN_LENGTH položek. Pokud se nepodaří alokovat paměť, funkce
+ * vrátí false.
+ */
+bool text_counts_init(text_counts_t *counts, size_t expected_tokens) {
+  size_t shard_count = 1;
+  while (shard_count < TEXT_MAX_SHARDS &&
+         shard_count * HT_SIZE * TEXT_CHAIN_LENGTH < expected_tokens) {
+    shard_count *= 2;
+  }
+  counts->shards = malloc(shard_count * sizeof(ht_table_t));
+  if (counts->shards == NULL) {
+    return false;
+  }
+  for (size_t i = 0; i < shard_count; i++) {
+    ht_init(&counts->shards[i]);
+  }
+  counts->shard_count = shard_count;
+  counts->tokens = NULL;
+  counts->counts = NULL;
+  counts->owned = NULL;
+  counts->size = 0;
+  counts->capacity = 0;
+  counts->dropped = 0;
+  return true;
+}
+
+/*
+ * Pomocná funkce která vrátí tabulku pro token (rozptylovací funkce
+ * FNV-1a).
+ */
+static ht_table_t *text_shard(text_counts_t *counts, const char *token) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const unsigned char *c = (const unsigned char *)token; *c != '\0';
+       c++) {
+    hash = (hash ^ *c) * 1099511628211ULL;
+  }
+  // The low bits of the product mix the last byte least, use the high ones.
+  return &counts->shards[(hash >> 32) & (counts->shard_count - 1)];
+}
+
+/*
+ * Pomocná funkce která započítá jeden výskyt tokenu.
+ *
+ * Token, který je platný jen po dobu volání (transient), se při prvním
+ * výskytu zkopíruje. Pokud se nepodaří alokovat paměť nebo je tokenů víc
+ * než TEXT_MAX_TOKENS, výskyt se započítá jen do counts->dropped.
+ */
+static void text_add(text_counts_t *counts, char *token, bool transient) {
+  ht_table_t *table = text_shard(counts, token);
+  float *index = ht_get(table, token);
+  if (index != NULL) {
+    counts->counts[(size_t)*index]++;
+    return;
+  }
+
+  if (counts->size == TEXT_MAX_TOKENS) {
+    counts->dropped++;
+    return;
+  }
+  if (counts->size == counts->capacity) {
+    size_t capacity = counts->capacity * 2 + 1024;
+    char **tokens = realloc(counts->tokens, capacity * sizeof(char *));
+    if (tokens != NULL) {
+      counts->tokens = tokens;
+    }
+    uint64_t *new_counts =
+        realloc(counts->counts, capacity * sizeof(uint64_t));
+    if (new_counts != NULL) {
+      counts->counts = new_counts;
+    }
+    bool *owned = realloc(counts->owned, capacity * sizeof(bool));
+    if (owned != NULL) {
+      counts->owned = owned;
+    }
+    if (tokens == NULL || new_counts == NULL || owned == NULL) {
+      counts->dropped++;
+      return;
+    }
+    counts->capacity = capacity;
+  }
+  if (transient) {
+    token = strdup(token);
+    if (token == NULL) {
+      counts->dropped++;
+      return;
+    }
+  }
+
+  ht_insert(table, token, (float)counts->size);
+  if (ht_search(table, token) == NULL) {
+    if (transient) {
+      free(token);
+    }
+    counts->dropped++;
+    return;
+  }
+  counts->tokens[counts->size] = token;
+  counts->counts[counts->size] = 1;
+  counts->owned[counts->size] = transient;
+  counts->size++;
+}
+
+/*
+ * Pomocná funkce která určí, zda bajt patří do slova.
+ */
+static bool text_word_byte(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+/*
+ * Pomocná funkce která převede písmeno ASCII na malé.
+ */
+static char text_lower(char c) {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+/*
+ * Pomocná funkce pro text_count s n = 1.
+ */
+static void text_count_words(text_counts_t *counts, char *text,
+                             size_t length) {
+  size_t i = 0;
+  while (i < length) {
+    while (i < length && !text_word_byte(text[i])) {
+      i++;
+    }
+    if (i == length) {
+      break;
+    }
+    size_t start = i;
+    while (i < length && text_word_byte(text[i])) {
+      text[i] = text_lower(text[i]);
+      i++;
+    }
+    if (i < length) {
+      text[i] = '\0';
+      text_add(counts, text + start, false);
+      i++;
+      continue;
+    }
+    // The last word ends the text, there is no byte for its terminator.
+    char *word = malloc(i - start + 1);
+    if (word == NULL) {
+      counts->dropped++;
+      return;
+    }
+    memcpy(word, text + start, i - start);
+    word[i - start] = '\0';
+    text_add(counts, word, true);
+    free(word);
+  }
+}
+
+/*
+ * Pomocná funkce která do bufferu gram zapíše posledních n slov
+ * oddělených mezerou, podle potřeby buffer zvětší. Při chybě alokace
+ * vrátí false.
+ */
+static bool text_join(char **gram, size_t *capacity, const char *text,
+                      const size_t starts[], const size_t lengths[],
+                      size_t words, int n) {
+  size_t gram_length = 0;
+  for (size_t word = words - n; word < words; word++) {
+    size_t word_length = lengths[word % n];
+    if (gram_length + word_length + 1 > *capacity) {
+      size_t bigger_capacity = (gram_length + word_length + 1) * 2;
+      char *bigger = realloc(*gram, bigger_capacity);
+      if (bigger == NULL) {
+        return false;
+      }
+      *gram = bigger;
+      *capacity = bigger_capacity;
+    }
+    for (size_t c = 0; c < word_length; c++) {
+      (*gram)[gram_length++] = text_lower(text[starts[word % n] + c]);
+    }
+    (*gram)[gram_length++] = ' ';
+  }
+  (*gram)[gram_length - 1] = '\0';
+  return true;
+}
+
+/*
+ * Pomocná funkce pro text_count s n > 1.
+ *
+ * Začátky a délky posledních n slov se ukládají do kruhového pole
+ * a n-gram se poskládá do pomocného bufferu.
+ */
+static void text_count_ngrams(text_counts_t *counts, const char *text,
+                              size_t length, int n) {
+  size_t *starts = malloc(n * sizeof(size_t));
+  size_t *lengths = malloc(n * sizeof(size_t));
+  size_t capacity = 256;
+  char *gram = malloc(capacity);
+  if (starts == NULL || lengths == NULL || gram == NULL) {
+    free(starts);
+    free(lengths);
+    free(gram);
+    return;
+  }
+
+  size_t words = 0;
+  size_t i = 0;
+  while (i < length) {
+    while (i < length && !text_word_byte(text[i])) {
+      i++;
+    }
+    if (i == length) {
+      break;
+    }
+    size_t start = i;
+    while (i < length && text_word_byte(text[i])) {
+      i++;
+    }
+    starts[words % n] = start;
+    lengths[words % n] = i - start;
+    words++;
+    if (words < (size_t)n) {
+      continue;
+    }
+    if (!text_join(&gram, &capacity, text, starts, lengths, words, n)) {
+      counts->dropped++;
+      break;
+    }
+    text_add(counts, gram, true);
+  }
+
+  free(starts);
+  free(lengths);
+  free(gram);
+}
+
+/*
+ * Započítání slov (n = 1) nebo n-gramů slov (n > 1) textu
+ * text[0..length-1].
+ *
+ * Pro n = 1 se slova nekopírují: text se změní (malá písmena, nuly za
+ * slovy) a tokeny ukazují do textu, musí tedy existovat déle než počty.
+ * Nulové bajty jsou oddělovače, opakované počítání stejného textu proto
+ * dá stejná slova. N-gram je n po sobě jdoucích slov oddělených jednou
+ * mezerou, každý různý n-gram se zkopíruje a text se nemění.
+ */
+void text_count(text_counts_t *counts, char *text, size_t length, int n) {
+  if (n <= 1) {
+    text_count_words(counts, text, length);
+  } else {
+    text_count_ngrams(counts, text, length, n);
+  }
+}
+
+// Token a jeho počet pro řazení v text_sorted
+typedef struct text_entry {
+  char *token;    // token
+  uint64_t count; // počet výskytů
+} text_entry_t;
+
+/*
+ * Pomocná funkce pro qsort která porovná tokeny dvou položek.
+ */
+static int text_compare(const void *a, const void *b) {
+  return strcmp(((const text_entry_t *)a)->token,
+                ((const text_entry_t *)b)->token);
+}
+
+/*
+ * Pomocná funkce která ze seřazených položek entries[0..size-1] vytvoří
+ * vyvážený podstrom (viz array_to_bst v ../btree/btree.c).
+ */
+static bst_str_node_t *text_build(const text_entry_t entries[], size_t size) {
+  if (size == 0) {
+    return NULL;
+  }
+  size_t mid = size / 2;
+  bst_str_node_t *node = BST_GEN_ALLOC(sizeof(bst_str_node_t));
+  if (node == NULL) {
+    return NULL;
+  }
+  node->key = entries[mid].token;
+  node->value = entries[mid].count > INT_MAX ? INT_MAX
+                                             : (int)entries[mid].count;
+  node->left = text_build(entries, mid);
+  node->right = text_build(entries + mid + 1, size - mid - 1);
+  return node;
+}
+
+/*
+ * Vytvoření stromu tokenů seřazených podle klíče.
+ *
+ * Vkládání tokenů po jednom by pro každý token porovnávalo řetězce podél
+ * celé cesty stromem, a to s výpadky cache. Tokeny se proto nejdříve
+ * seřadí funkcí qsort a z nich se vytvoří vyvážený strom bez porovnávání.
+ * Hodnota uzlu je počet výskytů, nejvýše INT_MAX. Klíče stromu ukazují na
+ * tokeny, strom je nutné zrušit funkcí bst_str_dispose dříve než počty.
+ */
+bst_str_node_t *text_sorted(text_counts_t *counts) {
+  text_entry_t *entries = malloc(counts->size * sizeof(text_entry_t));
+  if (entries == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < counts->size; i++) {
+    entries[i].token = counts->tokens[i];
+    entries[i].count = counts->counts[i];
+  }
+  qsort(entries, counts->size, sizeof(text_entry_t), text_compare);
+  bst_str_node_t *tree = text_build(entries, counts->size);
+  free(entries);
+  return tree;
+}
+
+/*
+ * Zrušení počtů tokenů a uvolnění zkopírovaných tokenů.
+ */
+void text_counts_dispose(text_counts_t *counts) {
+  for (size_t shard = 0; shard < counts->shard_count; shard++) {
+    ht_delete_all(&counts->shards[shard]);
+  }
+  for (size_t i = 0; i < counts->size; i++) {
+    if (counts->owned[i]) {
+      free(counts->tokens[i]);
+    }
+  }
+  free(counts->shards);
+  free(counts->tokens);
+  free(counts->counts);
+  free(counts->owned);
+  counts->shards = NULL;
+  counts->shard_count = 0;
+  counts->tokens = NULL;
+  counts->counts = NULL;
+  counts->owned = NULL;
+  counts->size = 0;
+  counts->capacity = 0;
+  counts->dropped = 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Hlavičkový soubor pro počítání slov a n-gramů v textu.
+ *
+ * Text se rozdělí na tokeny (slova nebo n-gramy slov), jejich počty se
+ * sečtou v tabulkách s rozptýlenými položkami z ../hashtable a výsledek
+ * se seřadí binárním vyhledávacím stromem bst_str z ../btree/gen.
+ */
+#ifndef IAL_TEXT_TEXT_H
+#define IAL_TEXT_TEXT_H
+
+#include "../btree/gen/bst_gen.h"
+#include "../hashtable/hashtable.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Největší počet různých tokenů, index tokenu musí být přesně float
+#define TEXT_MAX_TOKENS (1 << 24)
+
+// Vstupní soubor namapovaný do paměti
+typedef struct text_input {
+  char *data;    // obsah souboru, změny se do souboru nezapisují
+  size_t length; // délka souboru v bajtech
+} text_input_t;
+
+// Počty tokenů
+typedef struct text_counts {
+  ht_table_t *shards;  // tabulky token -> index tokenu
+  size_t shard_count;  // počet tabulek, mocnina dvou
+  char **tokens;       // tokeny v pořadí prvního výskytu
+  uint64_t *counts;    // počty výskytů tokenů
+  bool *owned;         // token je kopie, kterou je nutné uvolnit
+  size_t size;         // počet různých tokenů
+  size_t capacity;     // velikost polí tokens, counts a owned
+  uint64_t dropped;    // výskyty tokenů nad TEXT_MAX_TOKENS
+} text_counts_t;
+
+bool text_map(text_input_t *input, const char *path);
+void text_unmap(text_input_t *input);
+
+bool text_counts_init(text_counts_t *counts, size_t expected_tokens);
+void text_count(text_counts_t *counts, char *text, size_t length, int n);
+bst_str_node_t *text_sorted(text_counts_t *counts);
+void text_counts_dispose(text_counts_t *counts);
+
+#endif